@@ -0,0 +1,29 @@
+#include "bodyStore.hpp"
+
+void BodyStore::resize(size_t n) {
+	size_t padded = (n + BODY_LANES - 1) / BODY_LANES * BODY_LANES;
+	std::vector<float>* arrays[] = { &x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass };
+	for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+		arrays[a]->resize(padded, 0.0f);
+	}
+
+	//Bodies that just became padding must stop counting.
+	for (size_t i = n; i < padded; i++) {
+		x[i] = y[i] = z[i] = 0.0f;
+		mass[i] = 0.0f;
+	}
+	count = n;
+}
+
+void BodyStore::add(const glm::vec3& position, const glm::vec3& velocity, float m) {
+	size_t i = count;
+	resize(count + 1);
+	x[i] = position.x;
+	y[i] = position.y;
+	z[i] = position.z;
+	vx[i] = velocity.x;
+	vy[i] = velocity.y;
+	vz[i] = velocity.z;
+	ax[i] = ay[i] = az[i] = 0.0f;
+	mass[i] = m;
+}
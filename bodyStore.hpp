@@ -0,0 +1,41 @@
+#ifndef BODYSTORE_HPP
+#define BODYSTORE_HPP
+
+// Body state as a structure of arrays, one array per component, so the force
+// kernels can load 8 bodies' x (or y, or mass...) with a single instruction.
+#include <stddef.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Arrays are padded to a multiple of this many floats (one AVX register).
+const size_t BODY_LANES = 8;
+
+class BodyStore {
+public:
+	BodyStore() : count(0) {}
+
+	std::vector<float> x, y, z;
+	std::vector<float> vx, vy, vz;
+	std::vector<float> ax, ay, az;
+	std::vector<float> mass;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	// Length of the arrays, size() rounded up to BODY_LANES. The extra bodies
+	// sit at the origin with zero mass, so they never pull on anything.
+	size_t paddedSize() const { return x.size(); }
+
+	void clear() { resize(0); }
+	void resize(size_t n);
+	void add(const glm::vec3& position, const glm::vec3& velocity, float m);
+
+	glm::vec3 position(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+	glm::vec3 velocity(size_t i) const { return glm::vec3(vx[i], vy[i], vz[i]); }
+	glm::vec3 acceleration(size_t i) const { return glm::vec3(ax[i], ay[i], az[i]); }
+
+private:
+	size_t count;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "cookedTexture.hpp"
+
+static const size_t LEVEL_ALIGNMENT = 16;
+
+size_t blockBytes(TextureCodec codec) {
+	return codec == TEXTURE_BC1 ? 8 : 16;
+}
+
+size_t compressedSize(TextureCodec codec, int width, int height) {
+	//Partial blocks at the edges still take a whole block.
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(codec);
+}
+
+const char* codecName(TextureCodec codec) {
+	return codec == TEXTURE_BC1 ? "BC1" : codec == TEXTURE_BC7 ? "BC7" : "unknown";
+}
+
+std::string cookedTexturePath(const char* imagePath) {
+	return std::string(imagePath) + ".ctex";
+}
+
+size_t CookedTexture::totalBytes() const {
+	size_t bytes = 0;
+	for (size_t i = 0; i < levels.size(); i++) bytes += (size_t)levels[i].size;
+	return bytes;
+}
+
+bool openCookedTexture(const char* cookedPath, uint64_t sourceHash, uint64_t sourceSize, CookedTexture& out) {
+	out.levels.clear();
+	if (!out.file.open(cookedPath)) return false;
+
+	const MappedFile& file = out.file;
+	CookedTextureHeader& h = out.header;
+	bool ok = file.size() >= sizeof(h);
+	if (ok) {
+		memcpy(&h, file.data(), sizeof(h));
+		ok = memcmp(h.magic, "SSTX", 4) == 0 && h.version == COOKED_TEXTURE_VERSION &&
+			h.sourceHash == sourceHash && h.sourceSize == sourceSize &&
+			(h.codec == TEXTURE_BC1 || h.codec == TEXTURE_BC7) &&
+			h.width > 0 && h.height > 0 && h.levelCount > 0 && h.levelCount <= 32 &&
+			file.size() >= sizeof(h) + h.levelCount * sizeof(CookedTextureLevel);
+	}
+
+	//Every level must be the size its dimensions call for, and be in the file.
+	int width = (int)h.width, height = (int)h.height;
+	for (uint32_t i = 0; ok && i < h.levelCount; i++) {
+		CookedTextureLevel level;
+		memcpy(&level, file.data() + sizeof(h) + i * sizeof(level), sizeof(level));
+		ok = level.size == compressedSize((TextureCodec)h.codec, width, height) &&
+			level.offset % LEVEL_ALIGNMENT == 0 && level.offset + level.size <= file.size();
+		out.levels.push_back(level);
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	if (!ok) {
+		out.levels.clear();
+		out.file.close();
+	}
+	return ok;
+}
+
+bool writeCookedTexture(const char* cookedPath, TextureCodec codec, int width, int height,
+	const std::vector<std::vector<unsigned char> >& levels, uint64_t sourceHash, uint64_t sourceSize) {
+	CookedTextureHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "SSTX", 4);
+	h.version = COOKED_TEXTURE_VERSION;
+	h.sourceHash = sourceHash;
+	h.sourceSize = sourceSize;
+	h.codec = codec;
+	h.width = width;
+	h.height = height;
+	h.levelCount = (uint32_t)levels.size();
+
+	std::vector<CookedTextureLevel> index(levels.size());
+	uint64_t offset = sizeof(h) + levels.size() * sizeof(CookedTextureLevel);
+	for (size_t i = 0; i < levels.size(); i++) {
+		offset = (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+		index[i].offset = offset;
+		index[i].size = levels[i].size();
+		offset += levels[i].size();
+	}
+
+	//Same as the mesh cache: temporary name, then rename.
+	std::string temp = std::string(cookedPath) + ".tmp";
+	FILE* file = fopen(temp.c_str(), "wb");
+	if (file == NULL) return false;
+	bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+	if (ok && !index.empty()) ok = fwrite(&index[0], sizeof(CookedTextureLevel), index.size(), file) == index.size();
+	for (size_t i = 0; ok && i < levels.size(); i++) {
+		static const unsigned char zeros[LEVEL_ALIGNMENT] = { 0 };
+		long at = ftell(file);
+		ok = at >= 0 && fwrite(zeros, 1, (size_t)(index[i].offset - at), file) == (size_t)(index[i].offset - at);
+		if (ok && !levels[i].empty()) ok = fwrite(&levels[i][0], 1, levels[i].size(), file) == levels[i].size();
+	}
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		remove(temp.c_str());
+		return false;
+	}
+	remove(cookedPath);
+	return rename(temp.c_str(), cookedPath) == 0;
+}
@@ -0,0 +1,73 @@
+#ifndef COOKEDTEXTURE_HPP
+#define COOKEDTEXTURE_HPP
+
+// Textures cooked offline (textureCook) into block compressed mip chains,
+// written next to the image as <name>.jpg.ctex. Laid out like a KTX2 file:
+// a header, an index with the offset and size of every level, then the
+// levels, so the game maps the file and hands each level to
+// glCompressedTexImage2D as it is. No decoding, no glGenerateMipmap.
+//
+// File layout (little endian):
+//   CookedTextureHeader
+//   levelCount * CookedTextureLevel   level 0 (full size) first
+//   level data, each level at a 16 byte aligned offset
+//
+// The game only uses it while the source image's hash and size match, and
+// falls back to decoding the image when it doesn't or the GPU can't sample
+// the codec.
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "mappedFile.hpp"
+
+const uint32_t COOKED_TEXTURE_VERSION = 1;
+
+enum TextureCodec {
+	TEXTURE_BC1 = 1, // 4 bits per pixel, RGB. EXT_texture_compression_s3tc.
+	TEXTURE_BC7 = 2  // 8 bits per pixel, RGBA, better quality. ARB_texture_compression_bptc.
+};
+
+struct CookedTextureHeader {
+	char magic[4];       // "SSTX"
+	uint32_t version;
+	uint64_t sourceHash; // hashBytes of the image file
+	uint64_t sourceSize;
+	uint32_t codec;      // TextureCodec
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+};
+
+struct CookedTextureLevel {
+	uint64_t offset;
+	uint64_t size;
+};
+
+// Bytes per 4x4 block, 8 or 16.
+size_t blockBytes(TextureCodec codec);
+size_t compressedSize(TextureCodec codec, int width, int height);
+const char* codecName(TextureCodec codec);
+
+std::string cookedTexturePath(const char* imagePath);
+
+// A mapped, checked .ctex file.
+struct CookedTexture {
+	CookedTextureHeader header;
+	std::vector<CookedTextureLevel> levels;
+	MappedFile file;
+
+	const unsigned char* levelData(size_t level) const { return file.data() + levels[level].offset; }
+	size_t totalBytes() const;
+};
+
+// False when the file is missing, damaged, from another format version or
+// cooked from a different image.
+bool openCookedTexture(const char* cookedPath, uint64_t sourceHash, uint64_t sourceSize, CookedTexture& out);
+
+// levels[0] is width x height, each next one half the size (at least 1).
+bool writeCookedTexture(const char* cookedPath, TextureCodec codec, int width, int height,
+	const std::vector<std::vector<unsigned char> >& levels, uint64_t sourceHash, uint64_t sourceSize);
+
+#endif
@@ -0,0 +1,25 @@
+#include "cpuFeatures.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+bool cpuHasAvx2Fma() {
+#if !defined(HAVE_X86)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!fma || !osxsave) return false;
+	if ((_xgetbv(0) & 6) != 6) return false; //OS doesn't save the YMM registers.
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
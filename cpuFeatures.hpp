@@ -0,0 +1,24 @@
+#ifndef CPUFEATURES_HPP
+#define CPUFEATURES_HPP
+
+// What the CPU we're running on can do, for the kernels that have a SIMD
+// version. Those are compiled for their instruction set on their own (with
+// TARGET_AVX2), so the rest of the program still runs on CPUs without it.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+// SSE2 is part of x86-64, so it needs no check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2 1
+#endif
+
+bool cpuHasAvx2Fma();
+
+#endif
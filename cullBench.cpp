@@ -0,0 +1,95 @@
+// Frustum culling speed on a belt of bounding spheres around the sun, seen
+// from the game's camera: spheres per second for the scalar and the AVX2
+// kernel, on one thread and on all of them, from 1024 spheres up to
+// [max spheres] (default 1M). Also checks both kernels keep the same spheres.
+//
+// usage: cullBench [max spheres]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustumCull.hpp"
+#include "cpuFeatures.hpp"
+#include "threadPool.hpp"
+
+//Meteors of the game's belt, SWARM_METEOR_SCALE times planet.obj.
+static void seedBelt(SphereBounds& bounds, size_t n, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+	std::uniform_real_distribution<float> distance(10.0f, 60.0f);
+	std::uniform_real_distribution<float> height(-2.0f, 2.0f);
+	bounds.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		float a = angle(rng), r = distance(rng);
+		bounds.set(i, glm::vec3(r * cosf(a), r * sinf(a), height(rng)), 0.1f);
+	}
+}
+
+static double timeCull(FrustumCuller& culler, const Frustum& frustum, const SphereBounds& bounds) {
+	//Repeat until we have at least a quarter of a second to divide by.
+	int reps = 0;
+	auto start = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+	do {
+		culler.cull(frustum, bounds);
+		reps++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (seconds < 0.25);
+	return seconds / reps;
+}
+
+int main(int argc, char* argv[]) {
+	size_t maxSpheres = 1 << 20;
+	if (argc > 1) maxSpheres = (size_t)atoll(argv[1]);
+
+	//parallelFor also runs on the caller, so one worker less than the
+	//hardware threads keeps each of them busy with exactly one thread. With
+	//only one there is no pool, the all thread rows run on the caller too.
+	unsigned hardware = std::thread::hardware_concurrency();
+	std::unique_ptr<ThreadPool> pool;
+	if (hardware > 1) pool.reset(new ThreadPool(hardware - 1));
+	unsigned allThreads = pool ? pool->size() + 1 : 1;
+
+	bool avx2 = cpuHasAvx2Fma();
+	printf("threads: %u, avx2+fma: %s\n", allThreads, avx2 ? "yes" : "no");
+
+	//The game's starting view.
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(50.0f, 50.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	Frustum frustum(projection * view);
+
+	printf("\n%9s %10s %8s %10s %12s %9s\n", "spheres", "kernel", "threads", "ms/pass", "Mspheres/s", "visible");
+	for (size_t n = 1024; n <= maxSpheres; n *= 4) {
+		SphereBounds bounds;
+		seedBelt(bounds, n, 7);
+
+		for (int k = 0; k < 2; k++) {
+			CullKernel kernel = k == 0 ? CULL_SCALAR : CULL_AVX2;
+			if (kernel == CULL_AVX2 && !avx2) continue;
+			for (int t = 0; t < 2; t++) {
+				FrustumCuller culler(t == 0 ? NULL : pool.get(), kernel);
+				unsigned threads = t == 0 ? 1 : allThreads;
+				double seconds = timeCull(culler, frustum, bounds);
+				printf("%9zu %10s %8u %10.3f %12.1f %8.1f%%\n", n, cullKernelName(kernel), threads, seconds * 1000.0,
+					n / seconds * 1e-6, 100.0 * culler.lastVisible() / n);
+			}
+		}
+	}
+
+	//Both kernels have to keep exactly the same spheres.
+	if (avx2) {
+		SphereBounds bounds;
+		seedBelt(bounds, 100003, 11);
+		FrustumCuller scalar(pool.get(), CULL_SCALAR), vector(pool.get(), CULL_AVX2);
+		std::vector<uint32_t> a = scalar.cull(frustum, bounds);
+		const std::vector<uint32_t>& b = vector.cull(frustum, bounds);
+		printf("\navx2 vs scalar: %s (%zu visible)\n", a == b ? "same spheres" : "DIFFERENT", a.size());
+	}
+	return 0;
+}
@@ -0,0 +1,120 @@
+// O(n^2) gravity over a BodyStore: every body against every other body.
+// There is a plain C++ version and an AVX2/FMA one that handles 8 bodies per
+// instruction. The AVX2 one is compiled for that instruction set on its own,
+// so the rest of the program still runs on CPUs without it.
+#include <math.h>
+
+#include "gravity.hpp"
+#include "bodyStore.hpp"
+#include "cpuFeatures.hpp"
+#include "threadPool.hpp"
+
+GravityKernel bestGravityKernel() {
+	static const GravityKernel best = cpuHasAvx2Fma() ? KERNEL_AVX2 : KERNEL_SCALAR;
+	return best;
+}
+
+const char* gravityKernelName(GravityKernel kernel) {
+	return kernel == KERNEL_AVX2 ? "avx2+fma" : "scalar";
+}
+
+static void directSumScalar(BodyStore& b, size_t begin, size_t end, float G, float eps2) {
+	size_t n = b.paddedSize();
+	for (size_t i = begin; i < end; i++) {
+		float xi = b.x[i], yi = b.y[i], zi = b.z[i];
+		float axi = 0.0f, ayi = 0.0f, azi = 0.0f;
+		for (size_t j = 0; j < n; j++) {
+			//With softening the body itself adds dx = 0 times something finite, no need to skip it.
+			float dx = b.x[j] - xi;
+			float dy = b.y[j] - yi;
+			float dz = b.z[j] - zi;
+			float r2 = dx * dx + dy * dy + dz * dz + eps2;
+			float inv = 1.0f / sqrtf(r2);
+			float s = b.mass[j] * inv * inv * inv;
+			axi += dx * s;
+			ayi += dy * s;
+			azi += dz * s;
+		}
+		b.ax[i] = axi * G;
+		b.ay[i] = ayi * G;
+		b.az[i] = azi * G;
+	}
+}
+
+#if defined(HAVE_X86)
+//8 bodies i sit in the lanes of a register, every body j gets broadcast to all of them.
+TARGET_AVX2 static void directSumAvx2(BodyStore& b, size_t begin, size_t end, float G, float eps2) {
+	size_t n = b.paddedSize();
+	const __m256 vEps2 = _mm256_set1_ps(eps2);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+	const __m256 vG = _mm256_set1_ps(G);
+	const float* xs = b.x.data();
+	const float* ys = b.y.data();
+	const float* zs = b.z.data();
+	const float* ms = b.mass.data();
+
+	for (size_t i = begin; i < end; i += BODY_LANES) {
+		__m256 xi = _mm256_loadu_ps(xs + i);
+		__m256 yi = _mm256_loadu_ps(ys + i);
+		__m256 zi = _mm256_loadu_ps(zs + i);
+		__m256 axi = _mm256_setzero_ps();
+		__m256 ayi = _mm256_setzero_ps();
+		__m256 azi = _mm256_setzero_ps();
+
+		for (size_t j = 0; j < n; j++) {
+			__m256 dx = _mm256_sub_ps(_mm256_broadcast_ss(xs + j), xi);
+			__m256 dy = _mm256_sub_ps(_mm256_broadcast_ss(ys + j), yi);
+			__m256 dz = _mm256_sub_ps(_mm256_broadcast_ss(zs + j), zi);
+			__m256 r2 = _mm256_fmadd_ps(dx, dx, vEps2);
+			r2 = _mm256_fmadd_ps(dy, dy, r2);
+			r2 = _mm256_fmadd_ps(dz, dz, r2);
+
+			//rsqrt is only good to 12 bits, one Newton step brings it close to full float precision.
+			__m256 inv = _mm256_rsqrt_ps(r2);
+			__m256 r2half = _mm256_mul_ps(r2, half);
+			inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(r2half, _mm256_mul_ps(inv, inv), threeHalves));
+
+			__m256 inv3 = _mm256_mul_ps(_mm256_mul_ps(inv, inv), inv);
+			__m256 s = _mm256_mul_ps(_mm256_broadcast_ss(ms + j), inv3);
+			axi = _mm256_fmadd_ps(dx, s, axi);
+			ayi = _mm256_fmadd_ps(dy, s, ayi);
+			azi = _mm256_fmadd_ps(dz, s, azi);
+		}
+		_mm256_storeu_ps(b.ax.data() + i, _mm256_mul_ps(axi, vG));
+		_mm256_storeu_ps(b.ay.data() + i, _mm256_mul_ps(ayi, vG));
+		_mm256_storeu_ps(b.az.data() + i, _mm256_mul_ps(azi, vG));
+	}
+}
+#endif
+
+void directSumAccelerations(BodyStore& bodies, const GravitySettings& settings, ThreadPool* pool, GravityKernel kernel) {
+	size_t n = bodies.paddedSize();
+	if (n == 0) return;
+	const float eps2 = settings.softening * settings.softening;
+
+#if defined(HAVE_X86)
+	if (kernel == KERNEL_AVX2 && !cpuHasAvx2Fma()) kernel = KERNEL_SCALAR;
+#else
+	kernel = KERNEL_SCALAR;
+#endif
+
+	auto range = [&](size_t b, size_t e) {
+#if defined(HAVE_X86)
+		if (kernel == KERNEL_AVX2) {
+			directSumAvx2(bodies, b, e, settings.G, eps2);
+			return;
+		}
+#endif
+		directSumScalar(bodies, b, e, settings.G, eps2);
+	};
+
+	//Chunks stay multiples of BODY_LANES so the AVX2 kernel never straddles one.
+	if (pool) pool->parallelFor(0, n, 8 * BODY_LANES, range);
+	else range(0, n);
+}
+
+double directSumFlops(size_t bodies) {
+	//The usual convention for gravity kernels, rsqrt counted as one.
+	return 20.0 * (double)bodies * (double)bodies;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <chrono>
+#include <GL/glew.h>
+
+#include "frameRing.hpp"
+#include "glBuffer.hpp"
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+FrameRing::FrameRing(size_t bytes) : buffer(0), mapped(NULL), persistentMap(false), frameBytes(0),
+	frame(FRAME_RING_FRAMES - 1), used(0), frames(0), waits(0), grows(0), mapCalls(0), waitMilliseconds(0.0), peakBytes(0) {
+	for (int i = 0; i < FRAME_RING_FRAMES; i++) fences[i] = 0;
+	create(bytes);
+}
+
+//GL_COPY_WRITE_BUFFER for our own binds, the draw loop's state cache doesn't track it.
+void FrameRing::create(size_t bytes) {
+	frameBytes = alignUp(bytes > 0 ? bytes : 1, FRAME_RING_ALIGNMENT);
+	buffer = createPersistentBuffer(GL_COPY_WRITE_BUFFER, frameBytes * FRAME_RING_FRAMES, &mapped);
+	persistentMap = mapped != NULL;
+}
+
+void FrameRing::release() {
+	for (int i = 0; i < FRAME_RING_FRAMES; i++) {
+		if (fences[i]) glDeleteSync(fences[i]);
+		fences[i] = 0;
+	}
+	if (mapped) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		mapped = NULL;
+	}
+	if (buffer) glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	persistentMap = false;
+	used = 0;
+}
+
+void FrameRing::waitFor(GLsync& fence) {
+	if (!fence) return;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+		//The GPU is a whole ring behind. Flush, or the fence may never come.
+		auto start = std::chrono::steady_clock::now();
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		waits++;
+		waitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+bool FrameRing::beginFrame(size_t bytes) {
+	bool grown = false;
+	if (bytes > frameBytes || !buffer) {
+		//Rare (the belt got bigger), so simply wait for every frame in flight.
+		for (int i = 0; i < FRAME_RING_FRAMES; i++) waitFor(fences[i]);
+		size_t wanted = bytes + bytes / 2 > frameBytes * 2 ? bytes + bytes / 2 : frameBytes * 2;
+		release();
+		create(wanted);
+		frame = FRAME_RING_FRAMES - 1;
+		grows++;
+		grown = true;
+	}
+
+	frame = (frame + 1) % FRAME_RING_FRAMES;
+	waitFor(fences[frame]);
+	used = 0;
+
+	if (!persistentMap) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, frame * frameBytes, frameBytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		mapCalls++;
+	}
+	return grown;
+}
+
+unsigned char* FrameRing::allocate(size_t bytes, size_t alignment, size_t& offset) {
+	if (!mapped) return NULL;
+	size_t start = alignUp(used, alignment);
+	if (start + bytes > frameBytes) return NULL;
+	used = start + bytes;
+	if (used > peakBytes) peakBytes = used;
+	offset = frame * frameBytes + start;
+	return persistentMap ? mapped + offset : mapped + start;
+}
+
+void FrameRing::flush() {
+	if (persistentMap || !mapped) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	mapped = NULL;
+	mapCalls++;
+}
+
+void FrameRing::endFrame() {
+	flush();
+	if (fences[frame]) glDeleteSync(fences[frame]);
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frames++;
+}
+
+void FrameRing::printStats() const {
+	printf("Frame ring : %d x %.1f KB, %s; %u frames, peak %.1f KB a frame, %llu map/unmap calls, %u waits for the GPU (%.2f ms), grown %u times\n",
+		FRAME_RING_FRAMES, frameBytes / 1024.0, persistentMap ? "persistently mapped" : "mapped each frame",
+		frames, peakBytes / 1024.0, mapCalls, waits, waitMilliseconds, grows);
+}
@@ -0,0 +1,81 @@
+#ifndef FRAMERING_HPP
+#define FRAMERING_HPP
+
+// One buffer for the data that changes every frame (the camera, the object
+// list, the draw commands), cut into FRAME_RING_FRAMES regions used in turn.
+// The CPU fills one region while the GPU may still be reading the frames
+// before it. A fence at the end of each frame says when its region is free
+// again, so nothing is respecified, orphaned or waited on in the loop unless
+// the GPU really is that far behind.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistent and coherent,
+// and allocate() hands out pointers into it: no map, unmap or glBufferData
+// calls at all once running. Without it, beginFrame() maps the frame's region
+// (unsynchronized, the fence already keeps the GPU off it) and flush() unmaps
+// it, once a frame.
+//
+// A frame has to fit in its region. beginFrame() grows the buffer when asked
+// for more, after waiting for the GPU to be done with all of it.
+#include <stddef.h>
+#include <GL/glew.h>
+
+// Frames the CPU may be ahead of the GPU, one region each.
+const int FRAME_RING_FRAMES = 3;
+
+// Regions start at multiples of this, so allocations can ask for any
+// alignment up to it (uniform buffer offsets need 256 on some GPUs).
+const size_t FRAME_RING_ALIGNMENT = 256;
+
+class FrameRing {
+public:
+	// GL calls from here on, on the thread with the context.
+	explicit FrameRing(size_t frameBytes = 64 << 10);
+	~FrameRing() { release(); }
+	void release();
+
+	GLuint id() const { return buffer; }
+	bool persistent() const { return persistentMap; }
+	size_t frameCapacity() const { return frameBytes; }
+	size_t bytes() const { return frameBytes * FRAME_RING_FRAMES; }
+
+	// Moves on to the next region, with room for at least bytes, once the
+	// GPU is done with the frame that used it last. True when the buffer had
+	// to be made again to grow: id() changed and whatever pointed at the
+	// old one has to be pointed at the new one.
+	bool beginFrame(size_t bytes);
+
+	// bytes at a multiple of alignment in this frame's region. Where to
+	// write them, or NULL when the region is full; offset is where they are
+	// in the buffer, for the GL calls that read them.
+	unsigned char* allocate(size_t bytes, size_t alignment, size_t& offset);
+
+	// Done writing this frame, before the draws that read it.
+	void flush();
+
+	// Fences the frame's region, after the last draw that reads it.
+	void endFrame();
+
+	void printStats() const;
+
+private:
+	FrameRing(const FrameRing&);
+	FrameRing& operator=(const FrameRing&);
+
+	void create(size_t frameBytes);
+	void waitFor(GLsync& fence);
+
+	GLuint buffer;
+	unsigned char* mapped; // The whole buffer when persistent, else this frame's region while mapped.
+	bool persistentMap;
+	size_t frameBytes;
+	int frame;             // Region in use.
+	size_t used;           // Bytes of it allocated.
+	GLsync fences[FRAME_RING_FRAMES];
+
+	unsigned int frames, waits, grows;
+	unsigned long long mapCalls;
+	double waitMilliseconds;
+	size_t peakBytes;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <chrono>
+
+#include "frustumCull.hpp"
+#include "cpuFeatures.hpp"
+#include "threadPool.hpp"
+
+//Spheres per pool chunk, a multiple of CULL_LANES so the AVX2 kernel never straddles one.
+static const size_t CULL_CHUNK = 16384;
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	//glm is column major, clip = row . position for each row.
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++) {
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+	}
+	//-w <= x, y, z <= w.
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+	for (int p = 0; p < 6; p++) {
+		float length = glm::length(glm::vec3(planes[p]));
+		if (length > 0.0f) planes[p] = planes[p] * (1.0f / length);
+	}
+}
+
+bool Frustum::intersects(const glm::vec3& center, float radius) const {
+	for (int p = 0; p < 6; p++) {
+		if (glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius) return false;
+	}
+	return true;
+}
+
+void SphereBounds::resize(size_t n) {
+	size_t padded = (n + CULL_LANES - 1) / CULL_LANES * CULL_LANES;
+	x.resize(padded, 0.0f);
+	y.resize(padded, 0.0f);
+	z.resize(padded, 0.0f);
+	radius.resize(padded, -FLT_MAX);
+
+	//Spheres that just became padding must never be visible.
+	for (size_t i = n; i < padded; i++) {
+		x[i] = y[i] = z[i] = 0.0f;
+		radius[i] = -FLT_MAX;
+	}
+	count = n;
+}
+
+void SphereBounds::add(const glm::vec3& center, float r) {
+	size_t i = count;
+	resize(count + 1);
+	set(i, center, r);
+}
+
+float transformedRadius(const glm::mat4& model, float meshRadius) {
+	float scale2 = 0.0f;
+	for (int c = 0; c < 3; c++) {
+		float l2 = glm::dot(glm::vec3(model[c]), glm::vec3(model[c]));
+		if (l2 > scale2) scale2 = l2;
+	}
+	return meshRadius * sqrtf(scale2);
+}
+
+CullKernel bestCullKernel() {
+	static const CullKernel best = cpuHasAvx2Fma() ? CULL_AVX2 : CULL_SCALAR;
+	return best;
+}
+
+const char* cullKernelName(CullKernel kernel) {
+	return kernel == CULL_AVX2 ? "avx2+fma" : "scalar";
+}
+
+//Both kernels write the visible indices of [begin, end) to out and return how many.
+static size_t cullScalar(const Frustum& f, const SphereBounds& b, size_t begin, size_t end, uint32_t* out) {
+	size_t n = 0;
+	for (size_t i = begin; i < end; i++) {
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++) {
+			const glm::vec4& plane = f.planes[p];
+			inside = plane.x * b.x[i] + plane.y * b.y[i] + plane.z * b.z[i] + plane.w >= -b.radius[i];
+		}
+		if (inside) out[n++] = (uint32_t)i;
+	}
+	return n;
+}
+
+#if defined(HAVE_X86)
+//8 spheres sit in the lanes of a register, every plane gets broadcast to all of them.
+TARGET_AVX2 static size_t cullAvx2(const Frustum& f, const SphereBounds& b, size_t begin, size_t end, uint32_t* out) {
+	__m256 px[6], py[6], pz[6], pw[6];
+	for (int p = 0; p < 6; p++) {
+		px[p] = _mm256_set1_ps(f.planes[p].x);
+		py[p] = _mm256_set1_ps(f.planes[p].y);
+		pz[p] = _mm256_set1_ps(f.planes[p].z);
+		pw[p] = _mm256_set1_ps(f.planes[p].w);
+	}
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+	const float* xs = b.x.data();
+	const float* ys = b.y.data();
+	const float* zs = b.z.data();
+	const float* rs = b.radius.data();
+
+	size_t n = 0;
+	for (size_t i = begin; i < end; i += CULL_LANES) {
+		__m256 x = _mm256_loadu_ps(xs + i);
+		__m256 y = _mm256_loadu_ps(ys + i);
+		__m256 z = _mm256_loadu_ps(zs + i);
+		__m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(rs + i), signBit);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < 6; p++) {
+			__m256 d = _mm256_fmadd_ps(px[p], x, pw[p]);
+			d = _mm256_fmadd_ps(py[p], y, d);
+			d = _mm256_fmadd_ps(pz[p], z, d);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, negRadius, _CMP_LT_OQ));
+		}
+
+		//Every lane is written, only the visible ones move n on.
+		unsigned int inside = ~(unsigned int)_mm256_movemask_ps(outside);
+		for (unsigned int lane = 0; lane < CULL_LANES; lane++) {
+			out[n] = (uint32_t)(i + lane);
+			n += (inside >> lane) & 1;
+		}
+	}
+	return n;
+}
+#endif
+
+FrustumCuller::FrustumCuller(ThreadPool* pool, CullKernel kernel) : pool(pool), cullKernel(kernel),
+	tested(0), milliseconds(0.0), allTested(0), allVisible(0), culls(0), allMilliseconds(0.0) {
+#if defined(HAVE_X86)
+	if (cullKernel == CULL_AVX2 && !cpuHasAvx2Fma()) cullKernel = CULL_SCALAR;
+#else
+	cullKernel = CULL_SCALAR;
+#endif
+}
+
+const std::vector<uint32_t>& FrustumCuller::cull(const Frustum& frustum, const SphereBounds& bounds) {
+	auto start = std::chrono::steady_clock::now();
+	size_t n = bounds.paddedSize();
+	size_t chunks = (n + CULL_CHUNK - 1) / CULL_CHUNK;
+
+	//Each chunk writes its indices where its spheres start, then they are
+	//moved together. Never further than the chunk before them, so in place.
+	visible.resize(n);
+	chunkCounts.resize(chunks);
+	auto range = [&](size_t b, size_t e) {
+		uint32_t* out = visible.data() + b;
+#if defined(HAVE_X86)
+		if (cullKernel == CULL_AVX2) {
+			chunkCounts[b / CULL_CHUNK] = (uint32_t)cullAvx2(frustum, bounds, b, e, out);
+			return;
+		}
+#endif
+		chunkCounts[b / CULL_CHUNK] = (uint32_t)cullScalar(frustum, bounds, b, e, out);
+	};
+	if (pool && chunks > 1) pool->parallelFor(0, n, CULL_CHUNK, range);
+	else if (n > 0) {
+		for (size_t c = 0; c < chunks; c++) range(c * CULL_CHUNK, c + 1 < chunks ? (c + 1) * CULL_CHUNK : n);
+	}
+
+	size_t total = 0;
+	for (size_t c = 0; c < chunks; c++) {
+		if (total != c * CULL_CHUNK) memmove(visible.data() + total, visible.data() + c * CULL_CHUNK, chunkCounts[c] * sizeof(uint32_t));
+		total += chunkCounts[c];
+	}
+	visible.resize(total);
+
+	tested = bounds.size();
+	milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	allTested += tested;
+	allVisible += total;
+	allMilliseconds += milliseconds;
+	culls++;
+	return visible;
+}
+
+void FrustumCuller::printStats() const {
+	if (culls == 0) return;
+	printf("Culling (%s) : last %u of %u visible, %u culled, %.3f ms; %.1f%% visible and %.3f ms a pass over %u passes\n",
+		cullKernelName(cullKernel), (unsigned int)lastVisible(), (unsigned int)tested, (unsigned int)lastCulled(), milliseconds,
+		allTested ? 100.0 * allVisible / allTested : 100.0, allMilliseconds / culls, culls);
+}
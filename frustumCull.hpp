@@ -0,0 +1,108 @@
+#ifndef FRUSTUMCULL_HPP
+#define FRUSTUMCULL_HPP
+
+// Bounding sphere against view frustum culling, so bodies the camera can't
+// see never make it into the object list. The planes come straight out of
+// the Projection * View matrix (Gribb and Hartmann), and a sphere is culled
+// when it is wholly behind one of them.
+//
+// The spheres are a structure of arrays like BodyStore, so the AVX2 kernel
+// tests 8 of them per iteration: 6 planes, 3 FMAs and a compare each. It is
+// compiled for that instruction set on its own and picked at run time, and
+// big lists are cut into chunks on the thread pool, which is what keeps a
+// belt of a million bodies within a frame.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+// Arrays are padded to a multiple of this many floats (one AVX register).
+const size_t CULL_LANES = 8;
+
+struct Frustum {
+	Frustum() {}
+	// Planes of what viewProjection maps into GL's clip volume.
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	// Inward facing, normalized: dot(xyz, p) + w is the distance inside.
+	glm::vec4 planes[6]; // Left, right, bottom, top, near, far.
+
+	bool intersects(const glm::vec3& center, float radius) const;
+};
+
+class SphereBounds {
+public:
+	SphereBounds() : count(0) {}
+
+	std::vector<float> x, y, z, radius;
+
+	size_t size() const { return count; }
+	// size() rounded up to CULL_LANES. The padding has a radius of -FLT_MAX,
+	// which no frustum lets through.
+	size_t paddedSize() const { return x.size(); }
+
+	void clear() { resize(0); }
+	void resize(size_t n);
+	void set(size_t i, const glm::vec3& center, float r) {
+		x[i] = center.x;
+		y[i] = center.y;
+		z[i] = center.z;
+		radius[i] = r;
+	}
+	void add(const glm::vec3& center, float r);
+
+private:
+	size_t count;
+};
+
+// Radius of the sphere around model's origin that holds a mesh of meshRadius
+// after model (its largest scale).
+float transformedRadius(const glm::mat4& model, float meshRadius);
+
+enum CullKernel {
+	CULL_SCALAR,
+	CULL_AVX2,   // AVX2 + FMA, 8 spheres per iteration.
+};
+
+// Checked at run time (cpuHasAvx2Fma), the program itself is not built for AVX2.
+CullKernel bestCullKernel();
+const char* cullKernelName(CullKernel kernel);
+
+class FrustumCuller {
+public:
+	// pool may be NULL to run on the calling thread only. Asking for a kernel
+	// the CPU can't run falls back to the scalar one.
+	explicit FrustumCuller(ThreadPool* pool = NULL, CullKernel kernel = bestCullKernel());
+
+	// Indices of the spheres at least partly inside frustum, in order. Valid
+	// until the next cull().
+	const std::vector<uint32_t>& cull(const Frustum& frustum, const SphereBounds& bounds);
+
+	CullKernel kernel() const { return cullKernel; }
+
+	// Counts of the last cull() and of all of them.
+	size_t lastTested() const { return tested; }
+	size_t lastVisible() const { return visible.size(); }
+	size_t lastCulled() const { return tested - visible.size(); }
+	double lastMilliseconds() const { return milliseconds; }
+	uint64_t totalTested() const { return allTested; }
+	uint64_t totalVisible() const { return allVisible; }
+
+	void printStats() const;
+
+private:
+	ThreadPool* pool;
+	CullKernel cullKernel;
+	std::vector<uint32_t> visible;
+	std::vector<uint32_t> chunkCounts; // Visible spheres per chunk, compacted afterwards.
+
+	size_t tested;
+	double milliseconds;
+	uint64_t allTested, allVisible;
+	unsigned int culls;
+	double allMilliseconds;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include <GL/glew.h>
+
+#include "glBuffer.hpp"
+
+GLuint createPersistentBuffer(GLenum target, size_t size, unsigned char** mapped) {
+	GLuint buffer = 0;
+	*mapped = NULL;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	if (GLEW_ARB_buffer_storage) {
+		//Coherent, so the GPU sees writes without flushes.
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, NULL, flags);
+		*mapped = (unsigned char*)glMapBufferRange(target, 0, size, flags);
+		if (!*mapped) {
+			//Immutable storage can't be respecified, start over with a plain buffer.
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(target, buffer);
+		}
+	}
+	if (!*mapped) {
+		glBufferData(target, size, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(target, 0);
+	return buffer;
+}
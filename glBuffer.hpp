@@ -0,0 +1,16 @@
+#ifndef GLBUFFER_HPP
+#define GLBUFFER_HPP
+
+// Buffers the CPU keeps writing into while the GPU reads them, shared by the
+// texture upload ring (textureStreamer.hpp) and the per-frame data
+// (frameRing.hpp).
+#include <stddef.h>
+#include <GL/glew.h>
+
+// A new buffer of size bytes. With ARB_buffer_storage it is mapped once, for
+// writing, persistent and coherent, and *mapped points at it. Otherwise, or if
+// the driver won't map it, it is a plain GL_STREAM_DRAW buffer and *mapped is
+// NULL. Bound to target meanwhile, which is left unbound.
+GLuint createPersistentBuffer(GLenum target, size_t size, unsigned char** mapped);
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <GL/glew.h>
+
+#include "glState.hpp"
+
+GLStateCache::GLStateCache() : programKnown(false), unitKnown(false), vertexArrayKnown(false),
+	program(0), vertexArray(0), unit(0), frameIssued(0), frameElided(0), lastFrameIssued(0), lastFrameElided(0),
+	totalIssued(0), totalElided(0), frames(0) {
+}
+
+//Counts the call either way, true when it has to go to GL.
+bool GLStateCache::changes(bool known, GLuint current, GLuint wanted) {
+	if (known && current == wanted) {
+		frameElided++;
+		return false;
+	}
+	frameIssued++;
+	return true;
+}
+
+void GLStateCache::useProgram(GLuint wanted) {
+	if (!changes(programKnown, program, wanted)) return;
+	glUseProgram(wanted);
+	program = wanted;
+	programKnown = true;
+}
+
+void GLStateCache::activeTexture(int wanted) {
+	if (!changes(unitKnown, (GLuint)unit, (GLuint)wanted)) return;
+	glActiveTexture(GL_TEXTURE0 + wanted);
+	unit = wanted;
+	unitKnown = true;
+}
+
+void GLStateCache::bindTexture(int wantedUnit, GLenum target, GLuint texture) {
+	std::pair<int, GLenum> key(wantedUnit, target);
+	std::map<std::pair<int, GLenum>, GLuint>::iterator it = textures.find(key);
+	bool known = it != textures.end();
+	if (!changes(known, known ? it->second : 0, texture)) return;
+	activeTexture(wantedUnit);
+	glBindTexture(target, texture);
+	textures[key] = texture;
+}
+
+void GLStateCache::bindVertexArray(GLuint wanted) {
+	if (!changes(vertexArrayKnown, vertexArray, wanted)) return;
+	glBindVertexArray(wanted);
+	vertexArray = wanted;
+	vertexArrayKnown = true;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+	if (target == GL_ELEMENT_ARRAY_BUFFER) {
+		frameIssued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	std::map<GLenum, GLuint>::iterator it = buffers.find(target);
+	bool known = it != buffers.end();
+	if (!changes(known, known ? it->second : 0, buffer)) return;
+	glBindBuffer(target, buffer);
+	buffers[target] = buffer;
+}
+
+void GLStateCache::invalidate() {
+	programKnown = unitKnown = vertexArrayKnown = false;
+	textures.clear();
+	buffers.clear();
+}
+
+void GLStateCache::invalidateTextures() {
+	unitKnown = false;
+	textures.clear();
+}
+
+void GLStateCache::endFrame() {
+	lastFrameIssued = frameIssued;
+	lastFrameElided = frameElided;
+	totalIssued += frameIssued;
+	totalElided += frameElided;
+	frames++;
+	frameIssued = frameElided = 0;
+}
+
+void GLStateCache::printStats() const {
+	if (frames == 0) return;
+	printf("GL state : last frame %u calls issued, %u elided; %.1f issued and %.1f elided a frame over %u frames\n",
+		lastFrameIssued, lastFrameElided, (double)totalIssued / frames, (double)totalElided / frames, frames);
+}
@@ -0,0 +1,59 @@
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+
+// Shadow copy of the GL bindings the draw loop changes all the time: the
+// program, the active texture unit, the texture on each unit, the vertex
+// array and the buffer bindings. A call that would set what's already set
+// never reaches the driver. Counts both kinds per frame so the draw loop
+// can show what it saves.
+//
+// Only knows about changes made through it. Code that binds things itself
+// (texture uploads, the virtual texture's updates) leaves it guessing:
+// call invalidate() or invalidateTextures() after it and the next call of
+// each kind goes through.
+//
+// GL_ELEMENT_ARRAY_BUFFER belongs to the vertex array, so it isn't shadowed;
+// binding it always goes through.
+#include <map>
+#include <utility>
+#include <GL/glew.h>
+
+class GLStateCache {
+public:
+	GLStateCache();
+
+	void useProgram(GLuint program);
+	// Makes unit active when the texture has to be bound.
+	void bindTexture(int unit, GLenum target, GLuint texture);
+	void activeTexture(int unit);
+	void bindVertexArray(GLuint vertexArray);
+	void bindBuffer(GLenum target, GLuint buffer);
+
+	// Forget everything, GL state was changed behind our back.
+	void invalidate();
+	// Forget the texture bindings and the active unit only, after uploads.
+	void invalidateTextures();
+
+	// Closes the frame's counts. The last*() ones are the frame just closed.
+	void endFrame();
+	unsigned int lastIssued() const { return lastFrameIssued; }
+	unsigned int lastElided() const { return lastFrameElided; }
+
+	void printStats() const;
+
+private:
+	bool changes(bool known, GLuint current, GLuint wanted);
+
+	bool programKnown, unitKnown, vertexArrayKnown;
+	GLuint program, vertexArray;
+	int unit;
+	std::map<std::pair<int, GLenum>, GLuint> textures; // By unit and target.
+	std::map<GLenum, GLuint> buffers;
+
+	unsigned int frameIssued, frameElided;
+	unsigned int lastFrameIssued, lastFrameElided;
+	unsigned long long totalIssued, totalElided;
+	unsigned int frames;
+};
+
+#endif
@@ -0,0 +1,408 @@
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <utility>
+#include <glm/glm.hpp>
+
+#include "gravity.hpp"
+#include "threadPool.hpp"
+
+static const int LEAF_SIZE = 8;     //Bodies per leaf before we split it.
+static const int MORTON_LEVELS = 21; //3 * 21 bits of a 64 bit Morton code.
+static const int SPLIT_LEVEL = 2;   //Below this depth each subtree is built by its own job (up to 64 jobs).
+static const size_t BODY_GRAIN = 4096;
+
+GravitySettings defaultGravitySettings() {
+	GravitySettings s;
+	s.G = 1.0f;
+	s.theta = 0.5f;
+	s.softening = 0.05f;
+	s.directSumLimit = 8192;
+	return s;
+}
+
+//Spread the low 21 bits of v so there are two zero bits between each of them.
+static uint64_t expandBits(uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+	return v;
+}
+
+//x ends up in the highest bit of every 3 bit digit, then y, then z.
+static uint64_t mortonCode(const glm::vec3& p, const glm::vec3& boxMin, float scale) {
+	const float maxCell = (float)((1 << MORTON_LEVELS) - 1);
+	uint64_t x = (uint64_t)glm::clamp((p.x - boxMin.x) * scale, 0.0f, maxCell);
+	uint64_t y = (uint64_t)glm::clamp((p.y - boxMin.y) * scale, 0.0f, maxCell);
+	uint64_t z = (uint64_t)glm::clamp((p.z - boxMin.z) * scale, 0.0f, maxCell);
+	return expandBits(x) << 2 | expandBits(y) << 1 | expandBits(z);
+}
+
+typedef std::pair<uint64_t, int> MortonKey;
+
+//Sort chunks on the pool, then merge them pairwise, also on the pool.
+static void parallelSort(ThreadPool& pool, std::vector<MortonKey>& keys) {
+	size_t n = keys.size();
+	size_t chunk = std::max<size_t>(BODY_GRAIN, n / (pool.size() + 1) + 1);
+	pool.parallelFor(0, n, chunk, [&](size_t b, size_t e) {
+		std::sort(keys.begin() + b, keys.begin() + e);
+	});
+
+	std::vector<MortonKey> scratch(n);
+	for (size_t width = chunk; width < n; width *= 2) {
+		pool.parallelFor(0, n, 2 * width, [&](size_t b, size_t e) {
+			size_t mid = std::min(b + width, e);
+			std::merge(keys.begin() + b, keys.begin() + mid, keys.begin() + mid, keys.begin() + e, scratch.begin() + b);
+		});
+		keys.swap(scratch);
+	}
+}
+
+static void initNode(OctreeNode& node, int begin, int end, glm::vec3 center, float halfSize) {
+	node.centerOfMass = center;
+	node.mass = 0.0f;
+	node.boxCenter = center;
+	node.halfSize = halfSize;
+	node.firstChild = -1;
+	node.childCount = 0;
+	node.firstBody = begin;
+	node.bodyCount = end - begin;
+}
+
+static bool isLeaf(int begin, int end, int level) {
+	return end - begin <= LEAF_SIZE || level == MORTON_LEVELS;
+}
+
+BarnesHut::BarnesHut(ThreadPool& pool, const GravitySettings& settings)
+	: pool(pool), settings(settings), lastInteractions(0) {
+}
+
+void BarnesHut::build(const BodyStore& bodies) {
+	size_t n = bodies.size();
+	nodes.clear();
+	subtrees.clear();
+	if (n == 0) return;
+
+	//Bounding box, one partial box per chunk.
+	size_t boxChunks = (n + BODY_GRAIN - 1) / BODY_GRAIN;
+	std::vector<glm::vec3> mins(boxChunks), maxs(boxChunks);
+	pool.parallelFor(0, n, BODY_GRAIN, [&](size_t b, size_t e) {
+		glm::vec3 lo = bodies.position(b), hi = bodies.position(b);
+		for (size_t i = b + 1; i < e; i++) {
+			lo = glm::min(lo, bodies.position(i));
+			hi = glm::max(hi, bodies.position(i));
+		}
+		mins[b / BODY_GRAIN] = lo;
+		maxs[b / BODY_GRAIN] = hi;
+	});
+	glm::vec3 lo = mins[0], hi = maxs[0];
+	for (size_t c = 1; c < boxChunks; c++) {
+		lo = glm::min(lo, mins[c]);
+		hi = glm::max(hi, maxs[c]);
+	}
+
+	//Make it a cube, slightly bigger so nothing sits exactly on the far faces.
+	glm::vec3 extent = hi - lo;
+	float halfSize = std::max(extent.x, std::max(extent.y, extent.z)) * 0.5f * 1.001f + 1e-3f;
+	glm::vec3 center = (lo + hi) * 0.5f;
+	glm::vec3 boxMin = center - glm::vec3(halfSize);
+	float scale = (float)(1 << MORTON_LEVELS) / (2.0f * halfSize);
+
+	//Sort the bodies along a Morton curve, so every octree node is one contiguous range.
+	std::vector<MortonKey> keys(n);
+	pool.parallelFor(0, n, BODY_GRAIN, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++) {
+			keys[i] = MortonKey(mortonCode(bodies.position(i), boxMin, scale), (int)i);
+		}
+	});
+	parallelSort(pool, keys);
+
+	codes.resize(n);
+	order.resize(n);
+	sortedBodies.resize(n);
+	pool.parallelFor(0, n, BODY_GRAIN, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++) {
+			int body = keys[i].second;
+			codes[i] = keys[i].first;
+			order[i] = body;
+			sortedBodies[i] = glm::vec4(bodies.position(body), bodies.mass[body]);
+		}
+	});
+
+	//Top of the tree on this thread, everything below SPLIT_LEVEL as separate jobs.
+	std::vector<int> topNodes;
+	nodes.push_back(OctreeNode());
+	initNode(nodes[0], 0, (int)n, center, halfSize);
+	buildTop(0, 0, topNodes);
+
+	pool.parallelFor(0, subtrees.size(), 1, [&](size_t b, size_t e) {
+		for (size_t s = b; s < e; s++) {
+			Subtree& sub = subtrees[s];
+			sub.nodes.clear();
+			sub.nodes.push_back(nodes[sub.node]);
+			sub.nodes[0].firstChild = -1;
+			buildNode(sub.nodes, 0, sub.level);
+		}
+	});
+
+	//Splice the subtrees in. Their root goes where the placeholder was, the rest
+	//gets appended, with child indices moved by the subtree's base.
+	std::vector<int> bases(subtrees.size());
+	size_t total = nodes.size();
+	for (size_t s = 0; s < subtrees.size(); s++) {
+		bases[s] = (int)total;
+		total += subtrees[s].nodes.size() - 1;
+	}
+	nodes.resize(total);
+	pool.parallelFor(0, subtrees.size(), 1, [&](size_t b, size_t e) {
+		for (size_t s = b; s < e; s++) {
+			const std::vector<OctreeNode>& local = subtrees[s].nodes;
+			int shift = bases[s] - 1;
+			for (size_t j = 0; j < local.size(); j++) {
+				OctreeNode node = local[j];
+				if (node.firstChild >= 0) node.firstChild += shift;
+				if (j == 0) nodes[subtrees[s].node] = node;
+				else nodes[shift + j] = node;
+			}
+		}
+	});
+
+	//Children always come after their parent, so walking backwards sees them first.
+	for (size_t t = topNodes.size(); t-- > 0;) {
+		summarize(nodes[topNodes[t]], nodes);
+	}
+}
+
+void BarnesHut::splitChildren(std::vector<OctreeNode>& out, int node, int level) {
+	int begin = out[node].firstBody;
+	int end = begin + out[node].bodyCount;
+	glm::vec3 center = out[node].boxCenter;
+	float quarter = out[node].halfSize * 0.5f;
+	int shift = 3 * (MORTON_LEVELS - 1 - level);
+
+	//Codes are sorted and share everything above this digit, so each octant is one run.
+	out[node].firstChild = (int)out.size();
+	int b = begin;
+	for (int digit = 0; digit < 8 && b < end; digit++) {
+		int e = (int)(std::partition_point(codes.begin() + b, codes.begin() + end,
+			[&](uint64_t code) { return (int)((code >> shift) & 7) <= digit; }) - codes.begin());
+		if (e == b) continue;
+
+		glm::vec3 childCenter = center + glm::vec3(
+			(digit & 4) ? quarter : -quarter,
+			(digit & 2) ? quarter : -quarter,
+			(digit & 1) ? quarter : -quarter);
+		OctreeNode child;
+		initNode(child, b, e, childCenter, quarter);
+		out.push_back(child);
+		out[node].childCount++;
+		b = e;
+	}
+}
+
+void BarnesHut::buildTop(int node, int level, std::vector<int>& topNodes) {
+	OctreeNode& n = nodes[node];
+	if (isLeaf(n.firstBody, n.firstBody + n.bodyCount, level)) {
+		summarize(n, nodes);
+		return;
+	}
+	if (level == SPLIT_LEVEL) {
+		Subtree sub;
+		sub.node = node;
+		sub.level = level;
+		subtrees.push_back(sub);
+		return;
+	}
+
+	topNodes.push_back(node);
+	splitChildren(nodes, node, level);
+	int first = nodes[node].firstChild;
+	int count = nodes[node].childCount;
+	for (int c = 0; c < count; c++) {
+		buildTop(first + c, level + 1, topNodes);
+	}
+}
+
+void BarnesHut::buildNode(std::vector<OctreeNode>& out, int node, int level) {
+	if (!isLeaf(out[node].firstBody, out[node].firstBody + out[node].bodyCount, level)) {
+		splitChildren(out, node, level);
+		int first = out[node].firstChild;
+		int count = out[node].childCount;
+		for (int c = 0; c < count; c++) {
+			buildNode(out, first + c, level + 1);
+		}
+	}
+	summarize(out[node], out);
+}
+
+void BarnesHut::summarize(OctreeNode& node, const std::vector<OctreeNode>& all) {
+	glm::vec3 weighted = glm::vec3(0.0f);
+	float mass = 0.0f;
+	if (node.firstChild < 0) {
+		for (int i = node.firstBody; i < node.firstBody + node.bodyCount; i++) {
+			weighted += glm::vec3(sortedBodies[i]) * sortedBodies[i].w;
+			mass += sortedBodies[i].w;
+		}
+	}
+	else {
+		for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+			weighted += all[c].centerOfMass * all[c].mass;
+			mass += all[c].mass;
+		}
+	}
+	node.mass = mass;
+	node.centerOfMass = mass > 0.0f ? weighted / mass : node.boxCenter;
+}
+
+glm::vec3 BarnesHut::accelerationOf(int i, uint64_t& count) const {
+	const glm::vec3 p = glm::vec3(sortedBodies[i]);
+	const float eps2 = settings.softening * settings.softening;
+	const float theta2 = settings.theta * settings.theta;
+	glm::vec3 a = glm::vec3(0.0f);
+
+	int stack[8 * MORTON_LEVELS + 8];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const OctreeNode& node = nodes[stack[--top]];
+		if (node.firstChild < 0) {
+			//Leaf, go through its bodies one by one.
+			for (int j = node.firstBody; j < node.firstBody + node.bodyCount; j++) {
+				if (j == i) continue;
+				glm::vec3 d = glm::vec3(sortedBodies[j]) - p;
+				float r2 = glm::dot(d, d) + eps2;
+				float inv = 1.0f / sqrtf(r2);
+				a += d * (sortedBodies[j].w * inv * inv * inv);
+			}
+			count += node.bodyCount;
+			continue;
+		}
+
+		glm::vec3 d = node.centerOfMass - p;
+		float dist2 = glm::dot(d, d);
+		float size = 2.0f * node.halfSize;
+		if (size * size < theta2 * dist2) {
+			//Far enough away, the whole node acts like one body.
+			float r2 = dist2 + eps2;
+			float inv = 1.0f / sqrtf(r2);
+			a += d * (node.mass * inv * inv * inv);
+			count++;
+		}
+		else {
+			for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+				stack[top++] = c;
+			}
+		}
+	}
+	return a * settings.G;
+}
+
+void BarnesHut::accelerations(BodyStore& bodies) {
+	size_t n = sortedBodies.size();
+	std::atomic<uint64_t> total(0);
+	if (n > 0) {
+		pool.parallelFor(0, n, 256, [&](size_t b, size_t e) {
+			uint64_t count = 0;
+			for (size_t i = b; i < e; i++) {
+				glm::vec3 a = accelerationOf((int)i, count);
+				int body = order[i];
+				bodies.ax[body] = a.x;
+				bodies.ay[body] = a.y;
+				bodies.az[body] = a.z;
+			}
+			total += count;
+		});
+	}
+	lastInteractions = total;
+}
+
+NBodySystem::NBodySystem(ThreadPool& pool, const GravitySettings& settings)
+	: pool(pool), settings(settings), barnesHut(pool, settings), accCount(0) {
+}
+
+void NBodySystem::computeAccelerations() {
+	if (usesTree()) {
+		barnesHut.build(bodies);
+		barnesHut.accelerations(bodies);
+	}
+	else {
+		directSumAccelerations(bodies, settings, &pool);
+	}
+	accCount = bodies.size();
+}
+
+void NBodySystem::step(float dt) {
+	size_t n = bodies.size();
+	if (n == 0) return;
+
+	//Bodies were added or removed since last time, the old accelerations are useless.
+	if (accCount != n) {
+		computeAccelerations();
+	}
+
+	prevX.assign(bodies.x.begin(), bodies.x.begin() + n);
+	prevY.assign(bodies.y.begin(), bodies.y.begin() + n);
+	prevZ.assign(bodies.z.begin(), bodies.z.begin() + n);
+
+	float half = 0.5f * dt;
+	float* x = bodies.x.data();
+	float* y = bodies.y.data();
+	float* z = bodies.z.data();
+	float* vx = bodies.vx.data();
+	float* vy = bodies.vy.data();
+	float* vz = bodies.vz.data();
+	const float* ax = bodies.ax.data();
+	const float* ay = bodies.ay.data();
+	const float* az = bodies.az.data();
+	for (size_t i = 0; i < n; i++) {
+		vx[i] += ax[i] * half;
+		vy[i] += ay[i] * half;
+		vz[i] += az[i] * half;
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		z[i] += vz[i] * dt;
+	}
+
+	computeAccelerations();
+
+	for (size_t i = 0; i < n; i++) {
+		vx[i] += ax[i] * half;
+		vy[i] += ay[i] * half;
+		vz[i] += az[i] * half;
+	}
+}
+
+glm::vec3 NBodySystem::renderPosition(size_t i, float alpha) const {
+	glm::vec3 now = bodies.position(i);
+	if (i >= prevX.size()) return now; //Added after the last step.
+	return glm::mix(glm::vec3(prevX[i], prevY[i], prevZ[i]), now, alpha);
+}
+
+void seedDisk(BodyStore& bodies, size_t count, float centralMass, float innerRadius, float outerRadius,
+	const GravitySettings& settings, unsigned seed) {
+	bodies.clear();
+	if (count == 0) return;
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> thickness(0.0f, 0.05f);
+
+	bodies.add(glm::vec3(0.0f), glm::vec3(0.0f), centralMass);
+
+	//The disk as a whole weighs 1% of the central body.
+	float lightMass = count > 1 ? 0.01f * centralMass / (float)(count - 1) : 0.0f;
+	float r2min = innerRadius * innerRadius;
+	float r2max = outerRadius * outerRadius;
+	for (size_t i = 1; i < count; i++) {
+		float r = sqrtf(r2min + unit(rng) * (r2max - r2min)); //Uniform over the disk's area.
+		float angle = unit(rng) * 2.0f * 3.14159265f;
+		glm::vec3 position = glm::vec3(r * cosf(angle), r * sinf(angle), r * thickness(rng));
+		float speed = sqrtf(settings.G * centralMass / r);
+		glm::vec3 velocity = glm::vec3(-sinf(angle), cosf(angle), 0.0f) * speed; //Same direction as the planet's orbit.
+		bodies.add(position, velocity, lightMass);
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef GRAVITY_HPP
+#define GRAVITY_HPP
+
+// Newtonian N-body gravity. Forces come from a Barnes-Hut octree that is
+// rebuilt every step, which keeps the cost at O(n log n) instead of the
+// O(n^2) of summing every pair. Small systems use the direct sum anyway,
+// where a vectorised kernel beats walking the tree.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "bodyStore.hpp"
+
+class ThreadPool;
+
+struct GravitySettings {
+	float G;               // Gravitational constant, in scene units.
+	float theta;           // Opening angle. A node is used as one body when size / distance < theta.
+	float softening;       // Keeps close encounters from blowing up.
+	size_t directSumLimit; // Up to this many bodies NBodySystem sums all pairs instead of building a tree.
+};
+
+GravitySettings defaultGravitySettings();
+
+struct OctreeNode {
+	glm::vec3 centerOfMass;
+	float mass;
+	glm::vec3 boxCenter;
+	float halfSize;
+	int firstChild;   // Children are stored next to each other. -1 for leaves.
+	int childCount;
+	int firstBody;    // Range of the node's bodies in the tree's sorted order.
+	int bodyCount;
+};
+
+class BarnesHut {
+public:
+	BarnesHut(ThreadPool& pool, const GravitySettings& settings);
+
+	// Rebuild the octree around the current positions.
+	void build(const BodyStore& bodies);
+
+	// Fill in ax/ay/az of every body, from the tree built by the last build().
+	void accelerations(BodyStore& bodies);
+
+	// Body-body plus body-node interactions evaluated by the last accelerations().
+	uint64_t interactions() const { return lastInteractions; }
+	size_t nodeCount() const { return nodes.size(); }
+
+private:
+	// A part of the tree below SPLIT_LEVEL, built on its own and spliced in afterwards.
+	struct Subtree {
+		int node;   // Placeholder in nodes that the subtree's root replaces.
+		int level;
+		std::vector<OctreeNode> nodes;
+	};
+
+	void buildTop(int node, int level, std::vector<int>& topNodes);
+	void buildNode(std::vector<OctreeNode>& out, int node, int level);
+	void splitChildren(std::vector<OctreeNode>& out, int node, int level);
+	void summarize(OctreeNode& node, const std::vector<OctreeNode>& all);
+	glm::vec3 accelerationOf(int sortedIndex, uint64_t& count) const;
+
+	ThreadPool& pool;
+	GravitySettings settings;
+
+	std::vector<OctreeNode> nodes;
+	std::vector<Subtree> subtrees;
+	std::vector<uint64_t> codes;       // Morton code per sorted body.
+	std::vector<int> order;            // Sorted position -> index in the caller's vector.
+	std::vector<glm::vec4> sortedBodies; // xyz = position, w = mass, in Morton order.
+	uint64_t lastInteractions;
+};
+
+enum GravityKernel {
+	KERNEL_SCALAR,
+	KERNEL_AVX2,   // AVX2 + FMA, 8 bodies per instruction.
+};
+
+// Checked at run time (cpuHasAvx2Fma), the program itself is not built for AVX2.
+GravityKernel bestGravityKernel();
+const char* gravityKernelName(GravityKernel kernel);
+
+// O(n^2): every body against every other body, fills in ax/ay/az.
+// pool may be NULL to run on the calling thread only. Asking for a kernel the
+// CPU can't run falls back to the scalar one.
+void directSumAccelerations(BodyStore& bodies, const GravitySettings& settings, ThreadPool* pool,
+	GravityKernel kernel = bestGravityKernel());
+
+// Floating point operations of one direct sum pass over this many bodies.
+double directSumFlops(size_t bodies);
+
+// Bodies moving under their own gravity, integrated with leapfrog (kick-drift-kick).
+class NBodySystem {
+public:
+	NBodySystem(ThreadPool& pool, const GravitySettings& settings = defaultGravitySettings());
+
+	BodyStore bodies;
+
+	void step(float dt);
+
+	const BarnesHut& tree() const { return barnesHut; }
+	bool usesTree() const { return bodies.size() > settings.directSumLimit; }
+
+	// Position of body i between the start (alpha = 0) and the end (alpha = 1) of the last step.
+	glm::vec3 renderPosition(size_t i, float alpha) const;
+
+private:
+	void computeAccelerations();
+
+	std::vector<float> prevX, prevY, prevZ; // Positions before the last step.
+
+	ThreadPool& pool;
+	GravitySettings settings;
+	BarnesHut barnesHut;
+	size_t accCount; // Number of bodies the stored accelerations belong to, 0 if there are none.
+};
+
+// A massive body at the origin and count - 1 light bodies on roughly circular
+// orbits in a thick disk between innerRadius and outerRadius.
+void seedDisk(BodyStore& bodies, size_t count, float centralMass, float innerRadius, float outerRadius,
+	const GravitySettings& settings, unsigned seed);
+
+#endif
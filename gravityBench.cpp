@@ -0,0 +1,106 @@
+// Times the Barnes-Hut force pass against the direct O(n^2) sum and reports
+// interactions per second plus how far the tree's forces are from the exact ones.
+//
+// usage: gravityBench [bodies] [threads] [steps] [theta]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "gravity.hpp"
+#include "threadPool.hpp"
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+	size_t count = 100000;
+	unsigned threads = 0;
+	int steps = 5;
+	GravitySettings settings = defaultGravitySettings();
+	if (argc > 1) count = (size_t)atoll(argv[1]);
+	if (argc > 2) threads = (unsigned)atoi(argv[2]);
+	if (argc > 3) steps = atoi(argv[3]);
+	if (argc > 4) settings.theta = (float)atof(argv[4]);
+
+	ThreadPool pool(threads);
+	printf("bodies: %zu, threads: %u, theta: %.2f\n", count, pool.size(), settings.theta);
+
+	NBodySystem system(pool, settings);
+	seedDisk(system.bodies, count, 12000.0f, 10.0f, 60.0f, settings, 1234);
+
+	//Tree: build + force pass, a few times.
+	BarnesHut tree(pool, settings);
+	BodyStore& bodies = system.bodies;
+	double buildSeconds = 0.0, forceSeconds = 0.0;
+	unsigned long long interactions = 0;
+	for (int s = 0; s < steps; s++) {
+		auto start = std::chrono::steady_clock::now();
+		tree.build(bodies);
+		buildSeconds += secondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		tree.accelerations(bodies);
+		forceSeconds += secondsSince(start);
+		interactions += tree.interactions();
+	}
+	printf("\nBarnes-Hut\n");
+	printf("  nodes            : %zu\n", tree.nodeCount());
+	printf("  build            : %.3f ms/step\n", 1000.0 * buildSeconds / steps);
+	printf("  force pass       : %.3f ms/step\n", 1000.0 * forceSeconds / steps);
+	printf("  interactions     : %.0f per body\n", (double)interactions / steps / count);
+	printf("  interactions/sec : %.3e\n", interactions / forceSeconds);
+
+	//Plain scalar direct sum over all pairs as the reference. Above 20k bodies
+	//that gets slow, so only time a sample of the bodies and scale up.
+	size_t sample = count < 20000 ? count : 2000;
+	std::vector<glm::vec3> exact(sample);
+	const float eps2 = settings.softening * settings.softening;
+	auto start = std::chrono::steady_clock::now();
+	pool.parallelFor(0, sample, 16, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++) {
+			size_t self = i * (count / sample);
+			glm::vec3 p = bodies.position(self);
+			glm::vec3 a = glm::vec3(0.0f);
+			for (size_t j = 0; j < count; j++) {
+				if (j == self) continue;
+				glm::vec3 d = bodies.position(j) - p;
+				float r2 = glm::dot(d, d) + eps2;
+				float inv = 1.0f / sqrtf(r2);
+				a += d * (bodies.mass[j] * inv * inv * inv);
+			}
+			exact[i] = a * settings.G;
+		}
+	});
+	double directSeconds = secondsSince(start);
+	double directInteractions = (double)sample * (count - 1);
+	double directFullSeconds = directSeconds * count / sample;
+	printf("\nDirect sum%s\n", sample < count ? " (sampled)" : "");
+	printf("  force pass       : %.3f ms/step\n", 1000.0 * directFullSeconds);
+	printf("  interactions/sec : %.3e\n", directInteractions / directSeconds);
+
+	//Relative error of the tree against the exact sum.
+	double errSum = 0.0, errMax = 0.0;
+	for (size_t i = 0; i < sample; i++) {
+		glm::vec3 approx = bodies.acceleration(i * (count / sample));
+		double err = glm::length(approx - exact[i]) / (glm::length(exact[i]) + 1e-20);
+		errSum += err * err;
+		if (err > errMax) errMax = err;
+	}
+	printf("\nBarnes-Hut vs direct\n");
+	printf("  speedup          : %.1fx\n", directFullSeconds / (forceSeconds / steps));
+	printf("  rms rel. error   : %.2e\n", sqrt(errSum / sample));
+	printf("  max rel. error   : %.2e\n", errMax);
+
+	//And a few real integration steps for the whole thing. Above directSumLimit these use the tree.
+	start = std::chrono::steady_clock::now();
+	for (int s = 0; s < steps; s++) {
+		system.step(1.0f / 120.0f);
+	}
+	printf("\nNBodySystem::step  : %.3f ms/step (%s)\n", 1000.0 * secondsSince(start) / steps,
+		system.usesTree() ? "Barnes-Hut" : "direct sum");
+	return 0;
+}
@@ -0,0 +1,35 @@
+#include <string.h>
+
+#include "hash.hpp"
+
+static uint64_t rotl64(uint64_t v, int r) {
+	return (v << r) | (v >> (64 - r));
+}
+
+//Final mix so every input bit affects every output bit.
+static uint64_t fmix64(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+uint64_t hashBytes(const void* data, size_t size) {
+	const unsigned char* p = (const unsigned char*)data;
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)size;
+	size_t words = size / 8;
+	for (size_t i = 0; i < words; i++) {
+		uint64_t w;
+		memcpy(&w, p + 8 * i, 8);
+		h ^= rotl64(w * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+		h = rotl64(h, 27) * 5 + 0x52dce729;
+	}
+	uint64_t tail = 0;
+	for (size_t i = words * 8; i < size; i++) {
+		tail = (tail << 8) | p[i];
+	}
+	h ^= rotl64(tail * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+	return fmix64(h);
+}
@@ -0,0 +1,12 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Content hash of the files caches are built from. Not cryptographic, only has
+// to notice that a file changed. Eats 8 bytes per round so hashing is much
+// cheaper than parsing or decoding.
+uint64_t hashBytes(const void* data, size_t size);
+
+#endif
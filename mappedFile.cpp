@@ -0,0 +1,88 @@
+#include "mappedFile.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile() : base(NULL), length(0), opened(false) {
+#if defined(_WIN32)
+	fileHandle = NULL;
+	mappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	opened = true;
+	length = (size_t)fileSize.QuadPart;
+	if (length == 0) return true; //Can't map an empty file, but it's still a valid one.
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+	base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (base == NULL) {
+		close();
+		return false;
+	}
+	return true;
+#else
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+	opened = true;
+	length = (size_t)st.st_size;
+	if (length == 0) {
+		::close(fd);
+		return true;
+	}
+	void* p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); //The mapping keeps the file alive.
+	if (p == MAP_FAILED) {
+		close();
+		return false;
+	}
+	base = p;
+	return true;
+#endif
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+	if (base) UnmapViewOfFile(base);
+	if (mappingHandle) CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle) CloseHandle((HANDLE)fileHandle);
+	fileHandle = NULL;
+	mappingHandle = NULL;
+#else
+	if (base) munmap(base, length);
+#endif
+	base = NULL;
+	length = 0;
+	opened = false;
+}
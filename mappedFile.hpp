@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+// Read-only memory mapping of a whole file. The pages are only read from disk
+// when touched, and come straight from the OS file cache when warm.
+#include <stddef.h>
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const { return base != NULL || (opened && length == 0); }
+	const unsigned char* data() const { return (const unsigned char*)base; }
+	size_t size() const { return length; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	void* base;
+	size_t length;
+	bool opened;
+#if defined(_WIN32)
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "meshCache.hpp"
+#include "objloader.hpp"
+#include "meshOptimizer.hpp"
+
+std::string meshCachePath(const char* objPath) {
+	return std::string(objPath) + ".meshcache";
+}
+
+static bool validHeader(const MappedFile& file, uint64_t sourceHash, uint64_t sourceSize) {
+	if (file.size() < sizeof(MeshCacheHeader)) return false;
+	MeshCacheHeader h;
+	memcpy(&h, file.data(), sizeof(h));
+	if (memcmp(h.magic, "SSMC", 4) != 0) return false;
+	if (h.version != MESH_CACHE_VERSION || h.vertexSize != sizeof(PackedVertex)) return false;
+	if (h.sourceHash != sourceHash || h.sourceSize != sourceSize) return false;
+
+	//The blobs must actually be in the file (a crash mid-write, a truncated copy).
+	uint64_t vertexEnd = h.vertexOffset + (uint64_t)h.vertexCount * sizeof(PackedVertex);
+	uint64_t indexEnd = h.indexOffset + (uint64_t)h.indexCount * sizeof(unsigned int);
+	if (h.vertexOffset % 4 != 0 || h.indexOffset % 4 != 0) return false;
+	return vertexEnd <= file.size() && indexEnd <= file.size();
+}
+
+bool writeMeshCache(const char* cachePath, const PackedMesh& mesh, uint64_t sourceHash, uint64_t sourceSize) {
+	MeshCacheHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "SSMC", 4);
+	h.version = MESH_CACHE_VERSION;
+	h.sourceHash = sourceHash;
+	h.sourceSize = sourceSize;
+	h.vertexSize = sizeof(PackedVertex);
+	h.vertexCount = (uint32_t)mesh.vertices.size();
+	h.indexCount = (uint32_t)mesh.indices.size();
+	for (int i = 0; i < 4; i++) h.uvTransform[i] = mesh.uvTransform[i];
+	h.vertexOffset = sizeof(MeshCacheHeader);
+	h.indexOffset = h.vertexOffset + mesh.vertices.size() * sizeof(PackedVertex);
+
+	//Write to a temporary name and rename, so nobody ever maps half a cache.
+	std::string temp = std::string(cachePath) + ".tmp";
+	FILE* file = fopen(temp.c_str(), "wb");
+	if (file == NULL) return false;
+	bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+	if (ok && !mesh.vertices.empty()) ok = fwrite(&mesh.vertices[0], sizeof(PackedVertex), mesh.vertices.size(), file) == mesh.vertices.size();
+	if (ok && !mesh.indices.empty()) ok = fwrite(&mesh.indices[0], sizeof(unsigned int), mesh.indices.size(), file) == mesh.indices.size();
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		remove(temp.c_str());
+		return false;
+	}
+	remove(cachePath); //rename() won't replace an existing file on Windows.
+	return rename(temp.c_str(), cachePath) == 0;
+}
+
+bool loadMesh(const char* objPath, CachedMesh& out, ThreadPool* pool) {
+	auto start = std::chrono::steady_clock::now();
+	out.file.close();
+	out.built = PackedMesh();
+
+	uint64_t sourceHash, sourceSize;
+	{
+		MappedFile source;
+		if (!source.open(objPath)) {
+			printf("Impossible to open %s\n", objPath);
+			return false;
+		}
+		sourceHash = hashBytes(source.data(), source.size());
+		sourceSize = source.size();
+	}
+
+	out.sourceHash = sourceHash;
+
+	std::string cachePath = meshCachePath(objPath);
+	if (out.file.open(cachePath.c_str()) && validHeader(out.file, sourceHash, sourceSize)) {
+		MeshCacheHeader h;
+		memcpy(&h, out.file.data(), sizeof(h));
+		out.vertices = (const PackedVertex*)(out.file.data() + h.vertexOffset);
+		out.vertexCount = h.vertexCount;
+		out.indices = (const unsigned int*)(out.file.data() + h.indexOffset);
+		out.indexCount = h.indexCount;
+		out.uvTransform = glm::vec4(h.uvTransform[0], h.uvTransform[1], h.uvTransform[2], h.uvTransform[3]);
+		out.fromCache = true;
+	}
+	else {
+		out.file.close();
+		std::vector<unsigned int> indices;
+		std::vector<glm::vec3> vertices, normals;
+		std::vector<glm::vec2> uvs;
+		if (!loadOBJ(objPath, indices, vertices, uvs, normals, pool)) return false;
+		optimizeMesh(indices, vertices, uvs, normals);
+		packMesh(indices, vertices, uvs, normals, out.built);
+		if (!writeMeshCache(cachePath.c_str(), out.built, sourceHash, sourceSize)) {
+			printf("Could not write mesh cache %s, will parse %s again next time\n", cachePath.c_str(), objPath);
+		}
+
+		out.vertices = out.built.vertices.empty() ? NULL : &out.built.vertices[0];
+		out.vertexCount = out.built.vertices.size();
+		out.indices = out.built.indices.empty() ? NULL : &out.built.indices[0];
+		out.indexCount = out.built.indices.size();
+		out.uvTransform = out.built.uvTransform;
+		out.fromCache = false;
+	}
+
+	out.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%s : %s, %.2f ms\n", objPath, out.fromCache ? "from mesh cache" : "parsed, mesh cache written", out.loadMilliseconds);
+	return true;
+}
@@ -0,0 +1,66 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+// Binary cache of loaded, optimized and packed meshes, written next to the
+// OBJ as <name>.obj.meshcache the first time it is loaded. Later loads map the
+// cache file and hand its vertex and index blobs to OpenGL as they are.
+//
+// File layout (little endian):
+//   MeshCacheHeader
+//   vertexCount * PackedVertex   at header.vertexOffset
+//   indexCount * unsigned int    at header.indexOffset
+//
+// The cache is rebuilt whenever the OBJ's contents (hash and size), the
+// format version or sizeof(PackedVertex) don't match any more.
+#include <stdint.h>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "hash.hpp"
+#include "mappedFile.hpp"
+#include "vertexFormat.hpp"
+
+class ThreadPool;
+
+// Bump when anything that goes into the cached data changes (loader, optimizer, packing).
+const uint32_t MESH_CACHE_VERSION = 1;
+
+struct MeshCacheHeader {
+	char magic[4];          // "SSMC"
+	uint32_t version;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint32_t vertexSize;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t reserved;
+	float uvTransform[4];
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+};
+
+// A mesh ready for glBufferData. The pointers go into the mapped cache file
+// on a hit, or into the freshly built mesh on a miss.
+struct CachedMesh {
+	const PackedVertex* vertices;
+	size_t vertexCount;
+	const unsigned int* indices;
+	size_t indexCount;
+	glm::vec4 uvTransform;
+	bool fromCache;
+	double loadMilliseconds;
+	uint64_t sourceHash; // hashBytes of the OBJ
+
+	MappedFile file;
+	PackedMesh built;
+};
+
+std::string meshCachePath(const char* objPath);
+
+// Load objPath through the cache, building and writing the cache on a miss.
+// A miss parses the OBJ on pool when given one.
+bool loadMesh(const char* objPath, CachedMesh& out, ThreadPool* pool = NULL);
+
+bool writeMeshCache(const char* cachePath, const PackedMesh& mesh, uint64_t sourceHash, uint64_t sourceSize);
+
+#endif
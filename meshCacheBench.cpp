@@ -0,0 +1,43 @@
+// Cold vs. warm mesh loading: first load parses the OBJ and writes the mesh
+// cache, later loads only map the cache file.
+//
+// usage: meshCacheBench [file.obj ...]   (default: sun.obj planet.obj)
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+#include "meshCache.hpp"
+
+int main(int argc, char* argv[]) {
+	std::vector<const char*> paths;
+	for (int a = 1; a < argc; a++) paths.push_back(argv[a]);
+	if (paths.empty()) {
+		paths.push_back("sun.obj");
+		paths.push_back("planet.obj");
+	}
+
+	const int warmRuns = 20;
+	double coldTotal = 0.0, warmTotal = 0.0;
+	for (size_t p = 0; p < paths.size(); p++) {
+		remove(meshCachePath(paths[p]).c_str());
+
+		CachedMesh cold;
+		if (!loadMesh(paths[p], cold)) continue;
+
+		double warmMs = 0.0;
+		for (int r = 0; r < warmRuns; r++) {
+			CachedMesh warm;
+			loadMesh(paths[p], warm);
+			warmMs += warm.loadMilliseconds;
+		}
+		warmMs /= warmRuns;
+
+		printf("%s : %u vertices, %u indices, cold %.2f ms, warm %.3f ms (%.0fx)\n\n", paths[p],
+			(unsigned int)cold.vertexCount, (unsigned int)cold.indexCount, cold.loadMilliseconds, warmMs,
+			cold.loadMilliseconds / warmMs);
+		coldTotal += cold.loadMilliseconds;
+		warmTotal += warmMs;
+	}
+	printf("all meshes : cold %.2f ms, warm %.3f ms\n", coldTotal, warmTotal);
+	return 0;
+}
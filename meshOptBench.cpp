@@ -0,0 +1,55 @@
+// Vertex cache statistics of the body meshes before and after meshOptimizer.
+//
+// usage: meshOptBench [file.obj ...]   (default: sun.obj planet.obj)
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "objloader.hpp"
+#include "meshOptimizer.hpp"
+#include "vertexFormat.hpp"
+
+static void printStats(const char* stage, const std::vector<unsigned int>& indices, size_t vertexCount) {
+	VertexCacheStats s16 = measureVertexCache(indices, vertexCount, 16);
+	VertexCacheStats s32 = measureVertexCache(indices, vertexCount, 32);
+	printf("  %-14s ACMR %.3f  ATVR %.3f   | 32 entries: ACMR %.3f  ATVR %.3f\n", stage, s16.acmr, s16.atvr, s32.acmr, s32.atvr);
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<const char*> paths;
+	for (int a = 1; a < argc; a++) paths.push_back(argv[a]);
+	if (paths.empty()) {
+		paths.push_back("sun.obj");
+		paths.push_back("planet.obj");
+	}
+
+	for (size_t p = 0; p < paths.size(); p++) {
+		std::vector<unsigned int> indices;
+		std::vector<glm::vec3> vertices, normals;
+		std::vector<glm::vec2> uvs;
+		if (!loadOBJ(paths[p], indices, vertices, uvs, normals)) continue;
+
+		printf("%s (FIFO of %u entries unless noted)\n", paths[p], VERTEX_CACHE_SIZE);
+		printStats("file order", indices, vertices.size());
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<unsigned int> clusters;
+		optimizeVertexCache(indices, vertices.size(), &clusters);
+		double cacheMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		printStats("vertex cache", indices, vertices.size());
+
+		optimizeOverdraw(indices, vertices, clusters);
+		printStats("+ overdraw", indices, vertices.size());
+
+		optimizeVertexFetch(indices, vertices, uvs, normals);
+		printf("  %zu clusters, tipsify took %.2f ms\n", clusters.size(), cacheMs);
+
+		PackedMesh packed;
+		packMesh(indices, vertices, uvs, normals, packed);
+		printf("  ");
+		printVertexMemory(paths[p], packed.vertices.size());
+		printf("\n");
+	}
+	return 0;
+}
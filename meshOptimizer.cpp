@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "meshOptimizer.hpp"
+
+VertexCacheStats measureVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+	//A vertex put in the FIFO on miss number m is pushed out cacheSize misses later.
+	std::vector<unsigned int> insertedAt(vertexCount, 0);
+	unsigned int misses = 0;
+	unsigned int used = 0;
+	for (size_t i = 0; i < indices.size(); i++) {
+		unsigned int v = indices[i];
+		if (insertedAt[v] == 0) used++;
+		if (insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize) {
+			misses++;
+			insertedAt[v] = misses;
+		}
+	}
+
+	VertexCacheStats stats;
+	size_t triangles = indices.size() / 3;
+	stats.acmr = triangles ? (float)misses / triangles : 0.0f;
+	stats.atvr = used ? (float)misses / used : 0.0f;
+	return stats;
+}
+
+//Next vertex to fan around once the current one has no triangles left near
+//the cache: the most recently emitted vertex that still has some, otherwise
+//the first one in the mesh that does.
+static int skipDeadEnd(const std::vector<unsigned int>& liveCount, std::vector<unsigned int>& deadEnd, unsigned int& cursor) {
+	while (!deadEnd.empty()) {
+		unsigned int d = deadEnd.back();
+		deadEnd.pop_back();
+		if (liveCount[d] > 0) return (int)d;
+	}
+	while (cursor < liveCount.size()) {
+		if (liveCount[cursor] > 0) return (int)cursor;
+		cursor++;
+	}
+	return -1;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+	std::vector<unsigned int>* clusters, unsigned int cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (clusters) clusters->clear();
+	if (triangleCount == 0) return;
+
+	//Triangles using each vertex, as one flat array plus offsets.
+	std::vector<unsigned int> liveCount(vertexCount, 0);
+	for (size_t i = 0; i < indices.size(); i++) {
+		liveCount[indices[i]]++;
+	}
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		offsets[v + 1] = offsets[v] + liveCount[v];
+	}
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++) {
+		adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<unsigned int> deadEnd;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+
+	unsigned int time = cacheSize + 1;
+	unsigned int cursor = 0;
+	bool newCluster = true;
+	int fanning = skipDeadEnd(liveCount, deadEnd, cursor);
+
+	while (fanning >= 0) {
+		//Emit every triangle around the fanning vertex that isn't out yet.
+		candidates.clear();
+		for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+			unsigned int t = adjacency[a];
+			if (emitted[t]) continue;
+			if (newCluster && clusters) clusters->push_back((unsigned int)(output.size() / 3));
+			newCluster = false;
+
+			for (int c = 0; c < 3; c++) {
+				unsigned int v = indices[3 * t + c];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (time - cacheTime[v] > cacheSize) {
+					cacheTime[v] = time; //A miss, the vertex enters the cache.
+					time++;
+				}
+			}
+			emitted[t] = 1;
+		}
+
+		//Of the vertices just used, fan next around the one that will still be
+		//in the cache by the time its remaining triangles are emitted and has
+		//been there longest.
+		int best = -1;
+		int bestPriority = -1;
+		for (size_t c = 0; c < candidates.size(); c++) {
+			unsigned int v = candidates[c];
+			if (liveCount[v] == 0) continue;
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize) {
+				priority = (int)(time - cacheTime[v]);
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = (int)v;
+			}
+		}
+		if (best < 0) {
+			best = skipDeadEnd(liveCount, deadEnd, cursor);
+			newCluster = true;
+		}
+		fanning = best;
+	}
+
+	indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+	const std::vector<unsigned int>& clusters, float maxAcmrGrowth) {
+	size_t triangleCount = indices.size() / 3;
+	if (clusters.size() < 2) return;
+
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	for (size_t v = 0; v < positions.size(); v++) {
+		meshCenter += positions[v];
+	}
+	meshCenter = meshCenter / (float)positions.size();
+
+	//How far each cluster faces away from the middle of the mesh.
+	std::vector<std::pair<float, unsigned int> > order(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++) {
+		size_t begin = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (size_t t = begin; t < end; t++) {
+			const glm::vec3& a = positions[indices[3 * t + 0]];
+			const glm::vec3& b = positions[indices[3 * t + 1]];
+			const glm::vec3& d = positions[indices[3 * t + 2]];
+			glm::vec3 n = glm::cross(b - a, d - a); //Length is twice the area.
+			float triangleArea = glm::length(n);
+			center += (a + b + d) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		float facing = 0.0f;
+		if (area > 0.0f && glm::length(normal) > 0.0f) {
+			facing = glm::dot(center / area - meshCenter, glm::normalize(normal));
+		}
+		order[c] = std::make_pair(-facing, (unsigned int)c); //Most outward first.
+	}
+	std::stable_sort(order.begin(), order.end());
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (size_t o = 0; o < order.size(); o++) {
+		unsigned int c = order[o].second;
+		size_t begin = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		sorted.insert(sorted.end(), indices.begin() + 3 * begin, indices.begin() + 3 * end);
+	}
+
+	float before = measureVertexCache(indices, positions.size()).acmr;
+	float after = measureVertexCache(sorted, positions.size()).acmr;
+	if (after <= before * maxAcmrGrowth) {
+		indices.swap(sorted);
+	}
+}
+
+void optimizeVertexFetch(std::vector<unsigned int>& indices, std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals) {
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), unused);
+	unsigned int next = 0;
+	for (size_t i = 0; i < indices.size(); i++) {
+		if (remap[indices[i]] == unused) remap[indices[i]] = next++;
+	}
+	//Vertices no triangle uses go at the end, in their old order.
+	for (size_t v = 0; v < remap.size(); v++) {
+		if (remap[v] == unused) remap[v] = next++;
+	}
+
+	std::vector<glm::vec3> newVertices(vertices.size());
+	std::vector<glm::vec2> newUvs(uvs.size());
+	std::vector<glm::vec3> newNormals(normals.size());
+	for (size_t v = 0; v < remap.size(); v++) {
+		newVertices[remap[v]] = vertices[v];
+		if (v < uvs.size()) newUvs[remap[v]] = uvs[v];
+		if (v < normals.size()) newNormals[remap[v]] = normals[v];
+	}
+	for (size_t i = 0; i < indices.size(); i++) {
+		indices[i] = remap[indices[i]];
+	}
+	vertices.swap(newVertices);
+	uvs.swap(newUvs);
+	normals.swap(newNormals);
+}
+
+void optimizeMesh(std::vector<unsigned int>& indices, std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals) {
+	std::vector<unsigned int> clusters;
+	optimizeVertexCache(indices, vertices.size(), &clusters);
+	optimizeOverdraw(indices, vertices, clusters);
+	optimizeVertexFetch(indices, vertices, uvs, normals);
+}
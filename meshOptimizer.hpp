@@ -0,0 +1,44 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+// Reorders indexed triangle meshes so the GPU does less work drawing them:
+// triangles for the post-transform vertex cache (and, where that costs
+// little, front-to-back for less overdraw), then vertices in the order the
+// triangles first use them so vertex fetch walks memory forwards.
+#include <vector>
+#include <glm/glm.hpp>
+
+// Size of the FIFO the optimizer and the statistics assume. Desktop GPUs have
+// at least this much, so being tuned for it doesn't hurt on bigger ones.
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats {
+	float acmr; // Average cache miss ratio: vertices transformed per triangle. 0.5 is ideal, 3 is worst.
+	float atvr; // Average transform to vertex ratio: vertices transformed per unique vertex. 1 is ideal.
+};
+
+// Simulate a FIFO cache of cacheSize entries over the index buffer.
+VertexCacheStats measureVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Tipsify (Sander, Nehab, Barczak 2007): new triangle order for the vertex cache.
+// clusters gets the triangle index where each cluster of the new order starts,
+// those are the points where the order could be cut without losing cache hits.
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+	std::vector<unsigned int>* clusters = NULL, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Sort the clusters from optimizeVertexCache so outward facing ones come first,
+// then triangles on the far side of the mesh fail the depth test instead of
+// being shaded. Kept only if ACMR grows by less than maxAcmrGrowth (1.05 = 5%).
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+	const std::vector<unsigned int>& clusters, float maxAcmrGrowth = 1.05f);
+
+// Renumber vertices in order of first use and reorder the attribute arrays to match.
+void optimizeVertexFetch(std::vector<unsigned int>& indices, std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals);
+
+// All of the above, in that order.
+void optimizeMesh(std::vector<unsigned int>& indices, std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals);
+
+#endif
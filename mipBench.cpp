@@ -0,0 +1,71 @@
+// Time to build a whole mip chain on the CPU, per filter and kernel, and the
+// largest difference of the SIMD kernels from the scalar one.
+//
+// usage: mipBench [image ...]   (default: sun.jpg planet.jpg meteor.jpg)
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "mipChain.hpp"
+#include "cpuFeatures.hpp"
+
+int main(int argc, char* argv[]) {
+	std::vector<const char*> paths;
+	for (int a = 1; a < argc; a++) paths.push_back(argv[a]);
+	if (paths.empty()) {
+		paths.push_back("sun.jpg");
+		paths.push_back("planet.jpg");
+		paths.push_back("meteor.jpg");
+	}
+
+	std::vector<MipKernel> kernels;
+	kernels.push_back(MIP_KERNEL_SCALAR);
+#if defined(HAVE_SSE2)
+	kernels.push_back(MIP_KERNEL_SSE);
+#endif
+	if (cpuHasAvx2Fma()) kernels.push_back(MIP_KERNEL_AVX2);
+
+	const int runs = 10;
+	const MipFilter filters[] = { MIP_BOX, MIP_KAISER };
+	for (size_t p = 0; p < paths.size(); p++) {
+		int width, height, channels;
+		unsigned char* pixels = stbi_load(paths[p], &width, &height, &channels, 0);
+		if (!pixels) {
+			printf("Failed to load texture %s : %s\n", paths[p], stbi_failure_reason());
+			continue;
+		}
+		size_t levelBytes = (size_t)width * height * channels, chainBytes = mipChainBytes(width, height, channels);
+		printf("%s : %dx%d, %d channels, %d levels\n", paths[p], width, height, channels, mipLevelCount(width, height));
+
+		for (int f = 0; f < 2; f++) {
+			std::vector<unsigned char> reference;
+			for (size_t k = 0; k < kernels.size(); k++) {
+				std::vector<unsigned char> chain(chainBytes);
+				memcpy(&chain[0], pixels, levelBytes);
+				double best = 1e30;
+				for (int r = 0; r < runs; r++) {
+					auto start = std::chrono::steady_clock::now();
+					buildMipChain(&chain[0], width, height, channels, filters[f], kernels[k]);
+					double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					if (ms < best) best = ms;
+				}
+
+				int maxDifference = 0;
+				if (reference.empty()) reference = chain;
+				for (size_t i = levelBytes; i < chainBytes; i++) {
+					maxDifference = std::max(maxDifference, abs((int)chain[i] - (int)reference[i]));
+				}
+				printf("  %-6s %-8s %7.2f ms, %7.1f Mpixels/s of level 0, max difference from scalar %d\n",
+					mipFilterName(filters[f]), mipKernelName(kernels[k]), best,
+					(double)width * height / (best * 1000.0), maxDifference);
+			}
+		}
+		stbi_image_free(pixels);
+	}
+	return 0;
+}
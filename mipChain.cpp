@@ -0,0 +1,346 @@
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "mipChain.hpp"
+#include "cpuFeatures.hpp"
+
+// Levels are filtered as float planes, one per channel, so every kernel below
+// works on plain rows of floats whatever the channel count.
+
+//Kaiser windowed sinc for halving: 8 taps, at source pixels 2x-3 .. 2x+4 of output pixel x.
+static const int KAISER_TAPS = 8;
+
+//Buckets of linear values for going back to sRGB. Even at the steep dark end
+//a bucket is less than one code wide.
+static const int SRGB_BUCKETS = 4096;
+
+struct MipTables {
+	float toLinear[256];
+	float thresholds[255]; //Linear value halfway between sRGB codes i and i+1.
+	unsigned char toSrgb[SRGB_BUCKETS]; //Code for the start of each linear bucket, at most one short.
+	float kaiser[KAISER_TAPS];
+
+	MipTables() {
+		for (int i = 0; i < 256; i++) toLinear[i] = srgbToLinear(i / 255.0f);
+		for (int i = 0; i < 255; i++) thresholds[i] = srgbToLinear((i + 0.5f) / 255.0f);
+		for (int b = 0, code = 0; b < SRGB_BUCKETS; b++) {
+			while (code < 255 && (float)b / SRGB_BUCKETS >= thresholds[code]) code++;
+			toSrgb[b] = (unsigned char)code;
+		}
+
+		//Taps sit 0.5, 1.5, 2.5 and 3.5 source pixels either side of the output pixel's center.
+		const float alpha = 4.0f, radius = KAISER_TAPS / 2.0f;
+		float sum = 0.0f;
+		for (int k = 0; k < KAISER_TAPS; k++) {
+			float d = k - (KAISER_TAPS - 1) / 2.0f;
+			float t = d / radius;
+			float window = besselI0(alpha * sqrtf(1.0f - t * t)) / besselI0(alpha);
+			//Half the source frequency: sinc(d / 2).
+			float x = 3.14159265f * d / 2.0f;
+			kaiser[k] = window * sinf(x) / x;
+			sum += kaiser[k];
+		}
+		for (int k = 0; k < KAISER_TAPS; k++) kaiser[k] /= sum;
+	}
+
+	static float srgbToLinear(float c) {
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float besselI0(float x) {
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 20; k++) {
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+};
+
+static const MipTables& tables() {
+	static const MipTables t;
+	return t;
+}
+
+//Nearest sRGB code, the Kaiser lobes can overshoot either end.
+static unsigned char linearToSrgb(const MipTables& t, float v) {
+	if (!(v > 0.0f)) return 0;
+	if (v >= 1.0f) return 255;
+	int code = t.toSrgb[(int)(v * SRGB_BUCKETS)];
+	while (code < 255 && v >= t.thresholds[code]) code++;
+	return (unsigned char)code;
+}
+
+MipKernel bestMipKernel() {
+#if defined(HAVE_X86)
+	static const MipKernel best = cpuHasAvx2Fma() ? MIP_KERNEL_AVX2 : MIP_KERNEL_SSE;
+	return best;
+#else
+	return MIP_KERNEL_SCALAR;
+#endif
+}
+
+const char* mipKernelName(MipKernel kernel) {
+	return kernel == MIP_KERNEL_AVX2 ? "avx2+fma" : kernel == MIP_KERNEL_SSE ? "sse2" : "scalar";
+}
+
+const char* mipFilterName(MipFilter filter) {
+	return filter == MIP_KAISER ? "kaiser" : "box";
+}
+
+int mipLevelCount(int width, int height) {
+	int levels = 1;
+	while (width > 1 || height > 1) {
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		levels++;
+	}
+	return levels;
+}
+
+size_t mipLevelBytes(int width, int height, int channels, int level) {
+	for (int i = 0; i < level; i++) {
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return (size_t)width * height * channels;
+}
+
+size_t mipChainBytes(int width, int height, int channels) {
+	size_t bytes = 0;
+	for (int level = 0, levels = mipLevelCount(width, height); level < levels; level++) {
+		bytes += mipLevelBytes(width, height, channels, level);
+	}
+	return bytes;
+}
+
+// out[x] = average of a[2x], a[2x+1], b[2x], b[2x+1], from x = begin on.
+static void boxRowScalar(const float* a, const float* b, float* out, int begin, int outWidth, int width) {
+	for (int x = begin; x < outWidth; x++) {
+		int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+		out[x] = 0.25f * (a[x0] + a[x1] + b[x0] + b[x1]);
+	}
+}
+
+// out[x] = sum of weights[k] * rows[k][x].
+static void weightedSumScalar(const float* const* rows, const float* weights, int count, float* out, int begin, int n) {
+	for (int x = begin; x < n; x++) {
+		float sum = 0.0f;
+		for (int k = 0; k < count; k++) sum += weights[k] * rows[k][x];
+		out[x] = sum;
+	}
+}
+
+#if defined(HAVE_SSE2)
+static void boxRowSse(const float* a, const float* b, float* out, int outWidth, int width) {
+	int x = 0;
+	//Narrower rows have to clamp, leave those to the scalar loop.
+	if (width >= 2) {
+		const __m128 quarter = _mm_set1_ps(0.25f);
+		for (; x + 4 <= outWidth; x += 4) {
+			__m128 s0 = _mm_add_ps(_mm_loadu_ps(a + 2 * x), _mm_loadu_ps(b + 2 * x));
+			__m128 s1 = _mm_add_ps(_mm_loadu_ps(a + 2 * x + 4), _mm_loadu_ps(b + 2 * x + 4));
+			__m128 even = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 odd = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1));
+			_mm_storeu_ps(out + x, _mm_mul_ps(_mm_add_ps(even, odd), quarter));
+		}
+	}
+	boxRowScalar(a, b, out, x, outWidth, width);
+}
+
+static void weightedSumSse(const float* const* rows, const float* weights, int count, float* out, int n) {
+	int x = 0;
+	for (; x + 4 <= n; x += 4) {
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + x));
+		for (int k = 1; k < count; k++) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + x)));
+		_mm_storeu_ps(out + x, sum);
+	}
+	weightedSumScalar(rows, weights, count, out, x, n);
+}
+#endif
+
+#if defined(HAVE_X86)
+TARGET_AVX2 static void boxRowAvx2(const float* a, const float* b, float* out, int outWidth, int width) {
+	int x = 0;
+	if (width >= 2) {
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		for (; x + 8 <= outWidth; x += 8) {
+			__m256 s0 = _mm256_add_ps(_mm256_loadu_ps(a + 2 * x), _mm256_loadu_ps(b + 2 * x));
+			__m256 s1 = _mm256_add_ps(_mm256_loadu_ps(a + 2 * x + 8), _mm256_loadu_ps(b + 2 * x + 8));
+			//Shuffles work within 128 bit lanes, so pairs come out as 0 1 4 5 2 3 6 7.
+			__m256 even = _mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 odd = _mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1));
+			__m256 sum = _mm256_mul_ps(_mm256_add_ps(even, odd), quarter);
+			sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+			_mm256_storeu_ps(out + x, sum);
+		}
+	}
+	boxRowScalar(a, b, out, x, outWidth, width);
+}
+
+TARGET_AVX2 static void weightedSumAvx2(const float* const* rows, const float* weights, int count, float* out, int n) {
+	int x = 0;
+	for (; x + 8 <= n; x += 8) {
+		__m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + x));
+		for (int k = 1; k < count; k++) sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + x), sum);
+		_mm256_storeu_ps(out + x, sum);
+	}
+	weightedSumScalar(rows, weights, count, out, x, n);
+}
+#endif
+
+static void boxRow(const float* a, const float* b, float* out, int outWidth, int width, MipKernel kernel) {
+#if defined(HAVE_X86)
+	if (kernel == MIP_KERNEL_AVX2) return boxRowAvx2(a, b, out, outWidth, width);
+#endif
+#if defined(HAVE_SSE2)
+	if (kernel == MIP_KERNEL_SSE) return boxRowSse(a, b, out, outWidth, width);
+#endif
+	boxRowScalar(a, b, out, 0, outWidth, width);
+}
+
+static void weightedSum(const float* const* rows, const float* weights, int count, float* out, int n, MipKernel kernel) {
+#if defined(HAVE_X86)
+	if (kernel == MIP_KERNEL_AVX2) return weightedSumAvx2(rows, weights, count, out, n);
+#endif
+#if defined(HAVE_SSE2)
+	if (kernel == MIP_KERNEL_SSE) return weightedSumSse(rows, weights, count, out, n);
+#endif
+	weightedSumScalar(rows, weights, count, out, 0, n);
+}
+
+//Rows yBegin..yEnd of one plane of the next level down, into dst from its
+//start. src[y] is source row y; only the rows those outputs read (see
+//halvedRows) have to be there. Sources past the edges repeat the edge.
+static void halvePlane(const float* const* src, int width, int height, float* dst, int yBegin, int yEnd,
+	MipFilter filter, MipKernel kernel, std::vector<float>& row, std::vector<float>& even, std::vector<float>& odd) {
+	int outWidth = std::max(1, width / 2);
+	if (filter == MIP_BOX) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const float* a = src[std::min(2 * y, height - 1)];
+			const float* b = src[std::min(2 * y + 1, height - 1)];
+			boxRow(a, b, dst + (size_t)(y - yBegin) * outWidth, outWidth, width, kernel);
+		}
+		return;
+	}
+
+	//Separable: 8 rows down into one, then that row across. Across, source 2x+k
+	//is even[x + k/2] or odd[x + k/2], so the taps read contiguous floats too.
+	const float* weights = tables().kaiser;
+	row.resize(width);
+	even.resize(outWidth + KAISER_TAPS / 2);
+	odd.resize(outWidth + KAISER_TAPS / 2);
+	for (int y = yBegin; y < yEnd; y++) {
+		const float* rows[KAISER_TAPS];
+		for (int k = 0; k < KAISER_TAPS; k++) {
+			int sy = std::min(std::max(2 * y + k - KAISER_TAPS / 2 + 1, 0), height - 1);
+			rows[k] = src[sy];
+		}
+		weightedSum(rows, weights, KAISER_TAPS, &row[0], width, kernel);
+
+		for (int j = 0; j < outWidth + KAISER_TAPS / 2; j++) {
+			even[j] = row[std::min(std::max(2 * j - KAISER_TAPS / 2 + 1, 0), width - 1)];
+			odd[j] = row[std::min(std::max(2 * j - KAISER_TAPS / 2 + 2, 0), width - 1)];
+		}
+		const float* taps[KAISER_TAPS];
+		for (int m = 0; m < KAISER_TAPS / 2; m++) {
+			taps[2 * m] = &even[m];
+			taps[2 * m + 1] = &odd[m];
+		}
+		weightedSum(taps, weights, KAISER_TAPS, dst + (size_t)(y - yBegin) * outWidth, outWidth, kernel);
+	}
+}
+
+//The source rows that output rows yBegin..yEnd read, edges clamped.
+static void halvedRows(int height, int yBegin, int yEnd, MipFilter filter, int& first, int& last) {
+	first = std::max(2 * yBegin - (filter == MIP_BOX ? 0 : KAISER_TAPS / 2 - 1), 0);
+	last = std::min(2 * (yEnd - 1) + (filter == MIP_BOX ? 1 : KAISER_TAPS / 2), height - 1);
+}
+
+static MipKernel supportedKernel(MipKernel kernel) {
+	if (kernel == MIP_KERNEL_AVX2 && !cpuHasAvx2Fma()) kernel = MIP_KERNEL_SSE;
+#if !defined(HAVE_SSE2)
+	if (kernel == MIP_KERNEL_SSE) kernel = MIP_KERNEL_SCALAR;
+#endif
+	return kernel;
+}
+
+//8 bit rows first..last, interleaved, into linear planes of rows (last - first + 1) rows each.
+static void toLinearPlanes(const MipTables& t, const unsigned char* src, int width, int channels, int colorChannels,
+	int first, int last, float* planes) {
+	size_t pixels = (size_t)width * (last - first + 1);
+	for (int c = 0; c < channels; c++) {
+		float* plane = planes + c * pixels;
+		const unsigned char* in = src + (size_t)first * width * channels + c;
+		if (c < colorChannels) for (size_t i = 0; i < pixels; i++) plane[i] = t.toLinear[in[i * channels]];
+		else for (size_t i = 0; i < pixels; i++) plane[i] = in[i * channels] / 255.0f;
+	}
+}
+
+//Planes back to 8 bit, interleaved.
+static void fromLinearPlanes(const MipTables& t, const float* planes, size_t pixels, int channels, int colorChannels, unsigned char* out) {
+	for (int c = 0; c < channels; c++) {
+		const float* plane = planes + c * pixels;
+		unsigned char* o = out + c;
+		if (c < colorChannels) for (size_t i = 0; i < pixels; i++) o[i * channels] = linearToSrgb(t, plane[i]);
+		else for (size_t i = 0; i < pixels; i++) o[i * channels] = (unsigned char)std::min(255.0f, std::max(0.0f, plane[i] * 255.0f + 0.5f));
+	}
+}
+
+void buildMipChain(unsigned char* chain, int width, int height, int channels, MipFilter filter, MipKernel kernel) {
+	kernel = supportedKernel(kernel);
+	const MipTables& t = tables();
+	int colorChannels = channels == 2 || channels == 4 ? channels - 1 : channels;
+
+	//Level 0 into linear planes.
+	size_t pixels = (size_t)width * height;
+	std::vector<float> planes(pixels * channels), next, row, even, odd;
+	std::vector<const float*> rows;
+	toLinearPlanes(t, chain, width, channels, colorChannels, 0, height - 1, &planes[0]);
+
+	unsigned char* out = chain + pixels * channels;
+	int w = width, h = height;
+	for (int level = 1, levels = mipLevelCount(width, height); level < levels; level++) {
+		int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+		size_t nextPixels = (size_t)nw * nh;
+		next.resize(nextPixels * channels);
+		rows.resize(h);
+		for (int c = 0; c < channels; c++) {
+			for (int y = 0; y < h; y++) rows[y] = &planes[c * pixels + (size_t)y * w];
+			halvePlane(&rows[0], w, h, &next[c * nextPixels], 0, nh, filter, kernel, row, even, odd);
+		}
+		fromLinearPlanes(t, &next[0], nextPixels, channels, colorChannels, out);
+
+		out += nextPixels * channels;
+		planes.swap(next);
+		pixels = nextPixels;
+		w = nw;
+		h = nh;
+	}
+}
+
+void halveLevel(const unsigned char* src, int width, int height, int channels, unsigned char* dst, MipFilter filter, MipKernel kernel) {
+	//A band of output rows at a time: only the source rows under it are ever floats.
+	const int BAND_ROWS = 32;
+	kernel = supportedKernel(kernel);
+	const MipTables& t = tables();
+	int colorChannels = channels == 2 || channels == 4 ? channels - 1 : channels;
+	int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+
+	std::vector<float> planes, band, row, even, odd;
+	std::vector<const float*> rows(height);
+	for (int yBegin = 0; yBegin < outHeight; yBegin += BAND_ROWS) {
+		int yEnd = std::min(yBegin + BAND_ROWS, outHeight), first, last;
+		halvedRows(height, yBegin, yEnd, filter, first, last);
+		size_t pixels = (size_t)width * (last - first + 1), bandPixels = (size_t)outWidth * (yEnd - yBegin);
+		planes.resize(pixels * channels);
+		band.resize(bandPixels * channels);
+		toLinearPlanes(t, src, width, channels, colorChannels, first, last, &planes[0]);
+		for (int c = 0; c < channels; c++) {
+			for (int y = first; y <= last; y++) rows[y] = &planes[c * pixels + (size_t)(y - first) * width];
+			halvePlane(&rows[0], width, height, &band[c * bandPixels], yBegin, yEnd, filter, kernel, row, even, odd);
+		}
+		fromLinearPlanes(t, &band[0], bandPixels, channels, colorChannels, dst + (size_t)yBegin * outWidth * channels);
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef MIPCHAIN_HPP
+#define MIPCHAIN_HPP
+
+// Mip levels built on the CPU instead of with glGenerateMipmap, so they look
+// the same on every driver and cost the loader threads, not the GL thread.
+// Color is filtered in linear light: the images are sRGB, and averaging the
+// stored values directly makes every level darker than the one above it.
+// Alpha (the last of 2 or 4 channels) is filtered as it is.
+//
+// A chain is all levels tightly packed one after another, 8 bits per channel,
+// level 0 (width x height) first, each next one half the size, down to 1x1.
+#include <stddef.h>
+
+enum MipFilter {
+	MIP_BOX,    // Average of the 2x2 pixels above.
+	MIP_KAISER, // Kaiser windowed sinc over 8x8 pixels, sharper and without the box's aliasing.
+};
+
+enum MipKernel {
+	MIP_KERNEL_SCALAR,
+	MIP_KERNEL_SSE,  // SSE2, 4 pixels per instruction.
+	MIP_KERNEL_AVX2, // AVX2 + FMA, 8 pixels per instruction.
+};
+
+// Checked at run time, the program itself is not built for AVX2.
+MipKernel bestMipKernel();
+const char* mipKernelName(MipKernel kernel);
+const char* mipFilterName(MipFilter filter);
+
+int mipLevelCount(int width, int height);
+size_t mipLevelBytes(int width, int height, int channels, int level);
+size_t mipChainBytes(int width, int height, int channels);
+
+// chain holds level 0 and has room for mipChainBytes(); writes the other
+// levels after it. Runs on the calling thread only, so it can be called from
+// pool jobs. Asking for a kernel the CPU can't run falls back to the next best.
+void buildMipChain(unsigned char* chain, int width, int height, int channels, MipFilter filter,
+	MipKernel kernel = bestMipKernel());
+
+// Just the next level of one: dst gets max(1, width / 2) x max(1, height / 2)
+// pixels, the same as buildMipChain() would. Works a band of rows at a time,
+// for images too big to hold as floats (virtual textures).
+void halveLevel(const unsigned char* src, int width, int height, int channels, unsigned char* dst, MipFilter filter,
+	MipKernel kernel = bestMipKernel());
+
+#endif
@@ -0,0 +1,96 @@
+// GFLOP/s of the direct-sum gravity kernels for small and medium systems,
+// scalar against AVX2/FMA, on one thread and on all of them.
+//
+// usage: nbodyBench [max bodies] [peak GHz] [cores]
+//
+// Passing the CPU's clock in GHz also prints how close each run gets to the
+// AVX2 peak of 2 FMA units * 8 lanes * 2 flops = 32 flops per cycle per core.
+// Only physical cores have their own FMA units, so give their count as [cores]
+// when it isn't the number of hardware threads (SMT).
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <glm/glm.hpp>
+
+#include "gravity.hpp"
+#include "bodyStore.hpp"
+#include "cpuFeatures.hpp"
+#include "threadPool.hpp"
+
+static double timeKernel(BodyStore& bodies, const GravitySettings& settings, ThreadPool* pool, GravityKernel kernel) {
+	//Repeat until we have at least a quarter of a second to divide by.
+	int reps = 0;
+	auto start = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+	do {
+		directSumAccelerations(bodies, settings, pool, kernel);
+		reps++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (seconds < 0.25);
+	return seconds / reps;
+}
+
+int main(int argc, char* argv[]) {
+	size_t maxBodies = 8192;
+	double ghz = 0.0;
+	if (argc > 1) maxBodies = (size_t)atoll(argv[1]);
+	if (argc > 2) ghz = atof(argv[2]);
+
+	//parallelFor also runs on the caller, so one worker less than the
+	//hardware threads keeps each of them busy with exactly one thread. With
+	//only one there is no pool, the all thread rows run on the caller too.
+	unsigned hardware = std::thread::hardware_concurrency();
+	std::unique_ptr<ThreadPool> pool;
+	if (hardware > 1) pool.reset(new ThreadPool(hardware - 1));
+	unsigned allThreads = pool ? pool->size() + 1 : 1;
+	unsigned cores = allThreads;
+	if (argc > 3) cores = (unsigned)atoi(argv[3]);
+	if (cores == 0) cores = 1;
+
+	GravitySettings settings = defaultGravitySettings();
+	bool avx2 = cpuHasAvx2Fma();
+	printf("threads: %u, avx2+fma: %s\n", allThreads, avx2 ? "yes" : "no");
+	if (ghz > 0.0) {
+		printf("peak   : %.1f GFLOP/s per core, %.1f GFLOP/s on %u cores\n", 32.0 * ghz, 32.0 * ghz * cores, cores);
+	}
+	printf("\n%8s %10s %8s %12s %10s %9s\n", "bodies", "kernel", "threads", "ms/pass", "GFLOP/s", "% peak");
+
+	for (size_t n = 256; n <= maxBodies; n *= 2) {
+		BodyStore bodies;
+		seedDisk(bodies, n, 12000.0f, 10.0f, 60.0f, settings, 7);
+
+		for (int k = 0; k < 2; k++) {
+			GravityKernel kernel = k == 0 ? KERNEL_SCALAR : KERNEL_AVX2;
+			if (kernel == KERNEL_AVX2 && !avx2) continue;
+			for (int t = 0; t < 2; t++) {
+				ThreadPool* usePool = t == 0 ? NULL : pool.get();
+				unsigned threads = t == 0 ? 1 : allThreads;
+				double seconds = timeKernel(bodies, settings, usePool, kernel);
+				double gflops = directSumFlops(n) / seconds * 1e-9;
+				printf("%8zu %10s %8u %12.3f %10.2f", n, gravityKernelName(kernel), threads, seconds * 1000.0, gflops);
+				//More threads than cores share their FMA units, the peak doesn't grow.
+				if (ghz > 0.0) printf(" %8.1f%%", 100.0 * gflops / (32.0 * ghz * (threads < cores ? threads : cores)));
+				printf("\n");
+			}
+		}
+	}
+
+	//Both kernels should agree, AVX2 only differs by its rsqrt refinement.
+	if (avx2) {
+		BodyStore a, b;
+		seedDisk(a, 2048, 12000.0f, 10.0f, 60.0f, settings, 7);
+		b = a;
+		directSumAccelerations(a, settings, NULL, KERNEL_SCALAR);
+		directSumAccelerations(b, settings, NULL, KERNEL_AVX2);
+		double maxErr = 0.0;
+		for (size_t i = 0; i < a.size(); i++) {
+			double err = glm::length(a.acceleration(i) - b.acceleration(i)) / (glm::length(a.acceleration(i)) + 1e-20);
+			if (err > maxErr) maxErr = err;
+		}
+		printf("\nmax relative difference avx2 vs scalar: %.2e\n", maxErr);
+	}
+	return 0;
+}
@@ -0,0 +1,288 @@
+// OBJ loading speed: the mapped-buffer parser in objloader.cpp against the
+// fscanf loop it replaced, on a generated OBJ of the given size, and the
+// chunked parallel parser on 1 to 32 threads.
+//
+// usage: objBench [megabytes] [file.obj]   (default: 1024 MB, objBench.obj)
+// The file is only generated when it doesn't exist yet or has the wrong size.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "objloader.hpp"
+#include "threadPool.hpp"
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long long fileSize(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return -1;
+	fseek(file, 0, SEEK_END);
+	long long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+// A lat/long sphere, one ring of vertices after another, until the file is
+// about targetBytes long. Faces are written as v/vt/vn triangles like the
+// game's own OBJs so the old loader can read it too.
+static bool generateObj(const char* path, long long targetBytes) {
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+	//~200 bytes per grid vertex once faces are counted, the faces stop at targetBytes.
+	long long gridVertices = targetBytes / 200;
+	int segments = 1024;
+	int rings = (int)(gridVertices / (segments + 1));
+	if (rings < 2) rings = 2;
+
+	char line[256];
+	long long written = 0;
+	for (int r = 0; r <= rings; r++) {
+		float theta = 3.14159265f * r / rings;
+		for (int s = 0; s <= segments; s++) {
+			float phi = 6.28318531f * s / segments;
+			float x = sinf(theta) * cosf(phi), y = cosf(theta), z = sinf(theta) * sinf(phi);
+			written += fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+				x, y, z, (float)s / segments, (float)r / rings, x, y, z);
+		}
+	}
+	for (int r = 0; r < rings && written < targetBytes; r++) {
+		for (int s = 0; s < segments; s++) {
+			unsigned int a = r * (segments + 1) + s + 1;
+			unsigned int b = a + segments + 1;
+			int n = snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n",
+				a, a, a, b, b, b, a + 1, a + 1, a + 1, a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1);
+			fwrite(line, 1, n, file);
+			written += n;
+		}
+	}
+	return fclose(file) == 0;
+}
+
+static bool sameObj(const ObjData& a, const ObjData& b) {
+	if (a.positions.size() != b.positions.size() || a.uvs.size() != b.uvs.size() ||
+		a.normals.size() != b.normals.size() || a.corners.size() != b.corners.size()) return false;
+	for (size_t i = 0; i < a.corners.size(); i++) {
+		if (!(a.corners[i] == b.corners[i])) return false;
+	}
+	for (size_t i = 0; i < a.positions.size(); i++) {
+		if (a.positions[i] != b.positions[i]) return false;
+	}
+	return true;
+}
+
+// Negative indices that point into earlier chunks have to come out as in
+// parseOBJ, and ones that point before the file have to be turned down by
+// both, also when they are in the first chunk.
+static bool checkNegativeIndices(ThreadPool& pool) {
+	//Comments push the faces into later chunks than the elements they use.
+	std::string padding;
+	while (padding.size() < 3 * OBJ_MIN_CHUNK_BYTES) padding += "# padding padding padding padding padding padding\n";
+	const size_t chunks = 4;
+
+	struct Case {
+		const char* what;
+		std::string text;
+		bool valid;
+	};
+	const Case cases[] = {
+		{ "into earlier chunks", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n" + padding +
+			"f -3/-1/-1 -2/-1/-1 -1/-1/-1\nv 1 1 0\nf -4//-1 -1//-1 -2//-1\n", true },
+		{ "vt before the file, first chunk", "v 0 0 0\nf 1/-1/-1 1/-1/-1 1/-1/-1\nvt 0 0\nvn 0 0 1\n" + padding, false },
+		{ "v before the file, first chunk", "v 0 0 0\nf -1 -2 -1\n" + padding, false },
+		{ "vn before the file, later chunk", "v 0 0 0\nvn 0 0 1\n" + padding + "f 1//-2 1//-1 1//-1\n", false },
+	};
+	bool ok = true;
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		const Case& c = cases[i];
+		ObjData serial, parallel;
+		bool serialRead = parseOBJ(c.text.data(), c.text.size(), serial, c.what);
+		bool parallelRead = parseOBJParallel(c.text.data(), c.text.size(), parallel, c.what, pool, chunks);
+		bool same = serialRead == c.valid && parallelRead == c.valid && (!c.valid || sameObj(serial, parallel));
+		printf("  negative indices, %-32s : %s\n", c.what, same ? "ok" : "WRONG");
+		ok &= same;
+	}
+	return ok;
+}
+
+// The loader as it was before the mapped-buffer parser, for comparison.
+struct ScanfCornerHash {
+	size_t operator()(const ObjCorner& c) const {
+		size_t h = c.v;
+		h = h * 0x9E3779B1u + c.vt;
+		h = h * 0x9E3779B1u + c.vn;
+		return h;
+	}
+};
+
+static bool loadOBJScanf(const char* path, std::vector<unsigned int>& out_indices, std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs, std::vector<glm::vec3>& out_normals) {
+	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+	std::vector<glm::vec3> temp_vertices;
+	std::vector<glm::vec2> temp_uvs;
+	std::vector<glm::vec3> temp_normals;
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL) return false;
+	while (1) {
+		char lineHeader[128];
+		int res = fscanf(file, "%127s", lineHeader);
+		if (res == EOF) break;
+		if (strcmp(lineHeader, "v") == 0) {
+			glm::vec3 vertex;
+			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+			temp_vertices.push_back(vertex);
+		}
+		else if (strcmp(lineHeader, "vt") == 0) {
+			glm::vec2 uv;
+			fscanf(file, "%f %f\n", &uv.x, &uv.y);
+			uv.y = -uv.y;
+			temp_uvs.push_back(uv);
+		}
+		else if (strcmp(lineHeader, "vn") == 0) {
+			glm::vec3 normal;
+			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+			temp_normals.push_back(normal);
+		}
+		else if (strcmp(lineHeader, "f") == 0) {
+			unsigned int v[3], vt[3], vn[3];
+			int matches = fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], &v[2], &vt[2], &vn[2]);
+			if (matches != 9) {
+				fclose(file);
+				return false;
+			}
+			for (int c = 0; c < 3; c++) {
+				vertexIndices.push_back(v[c]);
+				uvIndices.push_back(vt[c]);
+				normalIndices.push_back(vn[c]);
+			}
+		}
+		else {
+			char stupidBuffer[1000];
+			fgets(stupidBuffer, 1000, file);
+		}
+	}
+	fclose(file);
+
+	std::unordered_map<ObjCorner, unsigned int, ScanfCornerHash> cornerToIndex;
+	cornerToIndex.reserve(vertexIndices.size() / 4);
+	for (size_t i = 0; i < vertexIndices.size(); i++) {
+		ObjCorner corner;
+		corner.v = vertexIndices[i] - 1;
+		corner.vt = uvIndices[i] - 1;
+		corner.vn = normalIndices[i] - 1;
+		auto found = cornerToIndex.find(corner);
+		if (found != cornerToIndex.end()) {
+			out_indices.push_back(found->second);
+			continue;
+		}
+		unsigned int newIndex = (unsigned int)out_vertices.size();
+		out_vertices.push_back(temp_vertices[corner.v]);
+		out_uvs.push_back(temp_uvs[corner.vt]);
+		out_normals.push_back(temp_normals[corner.vn]);
+		out_indices.push_back(newIndex);
+		cornerToIndex[corner] = newIndex;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	long long megabytes = argc > 1 ? atoll(argv[1]) : 1024;
+	const char* path = argc > 2 ? argv[2] : "objBench.obj";
+	long long target = megabytes * 1024 * 1024;
+
+	long long size = fileSize(path);
+	if (size < target * 90 / 100 || size > target * 105 / 100) {
+		printf("generating %s (%lld MB)...\n", path, megabytes);
+		auto start = std::chrono::steady_clock::now();
+		if (!generateObj(path, target)) {
+			printf("could not write %s\n", path);
+			return 1;
+		}
+		size = fileSize(path);
+		printf("  %.1f s\n", secondsSince(start));
+	}
+	double mb = size / (1024.0 * 1024.0);
+	printf("%s : %.1f MB\n\n", path, mb);
+
+	std::vector<unsigned int> indices, oldIndices;
+	std::vector<glm::vec3> vertices, normals, oldVertices, oldNormals;
+	std::vector<glm::vec2> uvs, oldUvs;
+
+	//Parsing alone and parsing plus merging vertices, for the new loader.
+	auto start = std::chrono::steady_clock::now();
+	std::vector<char> text;
+	{
+		FILE* file = fopen(path, "rb");
+		text.resize((size_t)size);
+		if (!file || fread(text.data(), 1, text.size(), file) != text.size()) {
+			printf("could not read %s\n", path);
+			return 1;
+		}
+		fclose(file);
+	}
+	printf("read into memory   : %7.2f s\n", secondsSince(start));
+	start = std::chrono::steady_clock::now();
+	ObjData data;
+	if (!parseOBJ(text.data(), text.size(), data, path)) return 1;
+	double parseSeconds = secondsSince(start);
+	printf("parseOBJ           : %7.2f s  %8.1f MB/s\n", parseSeconds, mb / parseSeconds);
+
+	//The parallel parser, the calling thread plus threads - 1 workers.
+	printf("\nparseOBJParallel (%u hardware threads)\n", std::thread::hardware_concurrency());
+	printf("  threads   seconds      MB/s   speedup\n");
+	printf("  %7d   %7.2f  %8.1f   %6.2fx\n", 1, parseSeconds, mb / parseSeconds, 1.0);
+	for (unsigned int threads = 2; threads <= 32; threads *= 2) {
+		ThreadPool pool(threads - 1);
+		ObjData parallelData;
+		start = std::chrono::steady_clock::now();
+		if (!parseOBJParallel(text.data(), text.size(), parallelData, path, pool)) return 1;
+		double seconds = secondsSince(start);
+		bool same = sameObj(data, parallelData);
+		printf("  %7u   %7.2f  %8.1f   %6.2fx%s\n", threads, seconds, mb / seconds, parseSeconds / seconds,
+			same ? "" : "  DIFFERENT FROM parseOBJ");
+		if (!same) return 1;
+	}
+	{
+		ThreadPool pool(3);
+		if (!checkNegativeIndices(pool)) return 1;
+	}
+	printf("\n");
+	data = ObjData();
+	std::vector<char>().swap(text);
+
+	start = std::chrono::steady_clock::now();
+	if (!loadOBJ(path, indices, vertices, uvs, normals)) return 1;
+	double newSeconds = secondsSince(start);
+	printf("loadOBJ            : %7.2f s  %8.1f MB/s\n", newSeconds, mb / newSeconds);
+
+	start = std::chrono::steady_clock::now();
+	if (!loadOBJScanf(path, oldIndices, oldVertices, oldUvs, oldNormals)) {
+		printf("the fscanf loader could not read %s\n", path);
+		return 1;
+	}
+	double oldSeconds = secondsSince(start);
+	printf("old fscanf loader  : %7.2f s  %8.1f MB/s\n", oldSeconds, mb / oldSeconds);
+	printf("speedup            : %7.1fx\n", oldSeconds / newSeconds);
+
+	//Both must build the same mesh. Floats can differ in the last bit between
+	//scanf's and our rounding, so compare with a tolerance.
+	bool same = indices == oldIndices && vertices.size() == oldVertices.size();
+	float maxError = 0.0f;
+	for (size_t v = 0; same && v < vertices.size(); v++) {
+		maxError = std::max(maxError, glm::length(vertices[v] - oldVertices[v]));
+		maxError = std::max(maxError, glm::length(uvs[v] - oldUvs[v]));
+		maxError = std::max(maxError, glm::length(normals[v] - oldNormals[v]));
+	}
+	printf("same mesh          : %s (largest difference %g)\n", same && maxError < 1e-6f ? "yes" : "NO", maxError);
+	return same && maxError < 1e-6f ? 0 : 1;
+}
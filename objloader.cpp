@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "objloader.hpp"
+#include "mappedFile.hpp"
+#include "threadPool.hpp"
+
+static inline bool isBlank(char c) {
+	return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(char c) {
+	return (unsigned char)(c - '0') < 10;
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+	while (p < end && isBlank(*p)) p++;
+	return p;
+}
+
+// Just past the next '\n', or end.
+static inline const char* skipLine(const char* p, const char* end) {
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	return newline ? newline + 1 : end;
+}
+
+// Every power of ten a double holds exactly. Mantissa times or divided by one
+// of these is correctly rounded (Clinger's fast path).
+static const double exactPowersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Reads a float the way from_chars would: no locale, no copying, no NUL
+// needed. Returns NULL if there's no number at p. The rare text the fast path
+// can't do exactly (huge exponents, inf, nan) goes to strtod.
+static const char* parseFloat(const char* p, const char* end, float& out) {
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	bool exact = true;
+	//Beyond 17 digits a float can't tell the difference, drop them.
+	for (; p < end && isDigit(*p); p++) {
+		anyDigits = true;
+		if (mantissa < 10000000000000000ULL) mantissa = mantissa * 10 + (*p - '0');
+		else exponent++;
+	}
+	if (p < end && *p == '.') {
+		p++;
+		for (; p < end && isDigit(*p); p++) {
+			anyDigits = true;
+			if (mantissa < 10000000000000000ULL) {
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			}
+		}
+	}
+	if (anyDigits && p < end && (*p == 'e' || *p == 'E')) {
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+')) {
+			negativeExponent = *e == '-';
+			e++;
+		}
+		if (e < end && isDigit(*e)) {
+			int value = 0;
+			for (; e < end && isDigit(*e); e++) {
+				if (value < 10000) value = value * 10 + (*e - '0');
+			}
+			exponent += negativeExponent ? -value : value;
+			p = e;
+		}
+	}
+
+	if (!anyDigits || exponent < -22 || exponent > 22) exact = false;
+	if (exact) {
+		double value = (double)mantissa;
+		value = exponent < 0 ? value / exactPowersOf10[-exponent] : value * exactPowersOf10[exponent];
+		out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	char buffer[64];
+	size_t length = 0;
+	while (start + length < end && length < sizeof(buffer) - 1 && !isBlank(start[length])
+		&& start[length] != '\n' && start[length] != '\r' && start[length] != '/') {
+		length++;
+	}
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	char* parsedEnd;
+	double value = strtod(buffer, &parsedEnd);
+	if (parsedEnd == buffer) return NULL;
+	out = (float)value;
+	return start + (parsedEnd - buffer);
+}
+
+// One index of a face corner, turned 0-based. Negative indices count back
+// from the last element read so far, count is how many that is. A chunk of
+// the file doesn't know what came before it, so with allowBefore a negative
+// index may point before the chunk (before is set); the result then wraps
+// around and is fixed up, and checked, once the counts of the earlier chunks
+// are known.
+static const char* parseIndex(const char* p, const char* end, size_t count, bool allowBefore,
+	unsigned int& out, bool& relative, bool& before) {
+	relative = false;
+	before = false;
+	if (p < end && *p == '-') {
+		relative = true;
+		p++;
+	}
+	if (p >= end || !isDigit(*p)) return NULL;
+	uint64_t value = 0;
+	for (; p < end && isDigit(*p); p++) {
+		if (value <= 0xFFFFFFFFULL) value = value * 10 + (*p - '0');
+	}
+	if (value == 0 || value > 0xFFFFFFFFULL) return NULL;
+	if (relative) {
+		if (value > count && !allowBefore) return NULL;
+		before = value > count;
+		out = (unsigned int)(count - value);
+	}
+	else {
+		//Forward references are checked once the whole file is read.
+		out = (unsigned int)(value - 1);
+	}
+	return p;
+}
+
+static const char* BAD_CORNER = "File can't be read by our simple parser, bad face corner";
+
+static inline bool atLineEnd(const char* p, const char* end) {
+	return p >= end || *p == '\n' || *p == '\r' || *p == '#';
+}
+
+// A corner of a chunk whose indices were negative, so still relative to the
+// chunk. components has bit 0 for v, 1 for vt, 2 for vn, and bits 3 to 5 for
+// those that point before the chunk. line is the chunk's line it is on.
+struct ObjRelativeCorner {
+	unsigned int corner;
+	unsigned int components;
+	unsigned int line;
+};
+
+// Adds the number of elements before a chunk to one of its relative indices.
+// False when an index that points before the chunk points before the file.
+static inline bool fixRelativeIndex(unsigned int& index, size_t before, bool pointsBefore) {
+	uint64_t fixed = (uint64_t)index + before;
+	//Those wrapped around, so they only land in the file if adding carries out.
+	if (pointsBefore) {
+		if (fixed < 0x100000000ULL) return false;
+		fixed -= 0x100000000ULL;
+	}
+	index = (unsigned int)fixed;
+	return true;
+}
+
+// Parses the lines in [begin, end). Returns NULL or what was wrong, lines is
+// the number of lines read or the line (from 1) the error is on. With
+// relative set, negative indices may point before begin and are listed there.
+static const char* parseRange(const char* begin, const char* end, ObjData& out,
+	std::vector<ObjRelativeCorner>* relative, unsigned int& lines) {
+	const char* p = begin;
+	unsigned int line = 1;
+	bool allowBefore = relative != NULL;
+
+	for (; p < end; p = skipLine(p, end), line++) {
+		p = skipBlanks(p, end);
+		if (p + 2 >= end) continue; //Too short for any record we read.
+		lines = line;
+
+		if (p[0] == 'v' && isBlank(p[1])) {
+			glm::vec3 vertex;
+			const char* q = p + 2;
+			if (!(q = parseFloat(skipBlanks(q, end), end, vertex.x)) ||
+				!(q = parseFloat(skipBlanks(q, end), end, vertex.y)) ||
+				!(q = parseFloat(skipBlanks(q, end), end, vertex.z))) {
+				return "a vertex needs three numbers";
+			}
+			out.positions.push_back(vertex);
+			p = q;
+		}
+		else if (p[0] == 'v' && p[1] == 't' && isBlank(p[2])) {
+			glm::vec2 uv(0.0f);
+			const char* q = parseFloat(skipBlanks(p + 3, end), end, uv.x);
+			if (!q) return "a texture coordinate needs at least one number";
+			q = skipBlanks(q, end);
+			if (!atLineEnd(q, end)) {
+				q = parseFloat(q, end, uv.y);
+				if (!q) return "bad texture coordinate";
+			}
+			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+			out.uvs.push_back(uv);
+			p = q;
+		}
+		else if (p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+			glm::vec3 normal;
+			const char* q = p + 3;
+			if (!(q = parseFloat(skipBlanks(q, end), end, normal.x)) ||
+				!(q = parseFloat(skipBlanks(q, end), end, normal.y)) ||
+				!(q = parseFloat(skipBlanks(q, end), end, normal.z))) {
+				return "a normal needs three numbers";
+			}
+			out.normals.push_back(normal);
+			p = q;
+		}
+		else if (p[0] == 'f' && isBlank(p[1])) {
+			ObjCorner corners[3]; //First, previous and current corner of the polygon.
+			unsigned int relativeBits[3] = { 0, 0, 0 };
+			unsigned int cornerCount = 0;
+			const char* q = skipBlanks(p + 2, end);
+			while (!atLineEnd(q, end)) {
+				ObjCorner& corner = corners[cornerCount == 0 ? 0 : 2];
+				unsigned int& bits = relativeBits[cornerCount == 0 ? 0 : 2];
+				bool rv = false, rvt = false, rvn = false, bv = false, bvt = false, bvn = false;
+				corner.vt = OBJ_NONE;
+				corner.vn = OBJ_NONE;
+				q = parseIndex(q, end, out.positions.size(), allowBefore, corner.v, rv, bv);
+				if (q && q < end && *q == '/') {
+					q++;
+					if (q < end && *q != '/') q = parseIndex(q, end, out.uvs.size(), allowBefore, corner.vt, rvt, bvt);
+					if (q && q < end && *q == '/') q = parseIndex(q + 1, end, out.normals.size(), allowBefore, corner.vn, rvn, bvn);
+				}
+				if (!q || !(q >= end || isBlank(*q) || atLineEnd(q, end))) {
+					return BAD_CORNER;
+				}
+				bits = (rv ? 1 : 0) | (rvt ? 2 : 0) | (rvn ? 4 : 0) | (bv ? 8 : 0) | (bvt ? 16 : 0) | (bvn ? 32 : 0);
+
+				//Polygons become a fan of triangles around their first corner.
+				if (cornerCount >= 2) {
+					for (int c = 0; c < 3; c++) {
+						if (relative && relativeBits[c]) {
+							ObjRelativeCorner r = { (unsigned int)out.corners.size(), relativeBits[c], line };
+							relative->push_back(r);
+						}
+						out.corners.push_back(corners[c]);
+					}
+				}
+				if (cornerCount >= 1) {
+					corners[1] = corners[2];
+					relativeBits[1] = relativeBits[2];
+				}
+				cornerCount++;
+				q = skipBlanks(q, end);
+			}
+			if (cornerCount < 3) return "a face needs at least three corners";
+			p = q;
+		}
+		// Anything else (comments, o, g, s, usemtl...) : skip the line.
+	}
+	lines = line - 1;
+	return NULL;
+}
+
+bool parseOBJ(const char* text, size_t size, ObjData& out, const char* name) {
+	unsigned int lines = 0;
+	const char* error = parseRange(text, text + size, out, NULL, lines);
+	if (error) {
+		printf("%s:%u : %s\n", name, lines, error);
+		return false;
+	}
+	return true;
+}
+
+bool parseOBJParallel(const char* text, size_t size, ObjData& out, const char* name, ThreadPool& pool, size_t chunks) {
+	if (chunks == 0) chunks = 4 * ((size_t)pool.size() + 1);
+	if (chunks > size / OBJ_MIN_CHUNK_BYTES) chunks = size / OBJ_MIN_CHUNK_BYTES;
+	if (chunks <= 1) return parseOBJ(text, size, out, name);
+
+	//Cut at line starts: each cut moves forward to just after a newline.
+	const char* end = text + size;
+	std::vector<const char*> starts(chunks + 1);
+	starts[0] = text;
+	for (size_t c = 1; c < chunks; c++) {
+		const char* cut = text + size / chunks * c;
+		if (cut < starts[c - 1]) cut = starts[c - 1];
+		starts[c] = cut < end ? skipLine(cut, end) : end;
+	}
+	starts[chunks] = end;
+
+	std::vector<ObjData> parts(chunks);
+	std::vector<std::vector<ObjRelativeCorner> > relative(chunks);
+	std::vector<unsigned int> lines(chunks, 0);
+	std::vector<const char*> errors(chunks, (const char*)NULL);
+	pool.parallelFor(0, chunks, 1, [&](size_t b, size_t e) {
+		for (size_t c = b; c < e; c++) {
+			errors[c] = parseRange(starts[c], starts[c + 1], parts[c], &relative[c], lines[c]);
+		}
+	});
+
+	//Where each chunk's records go in the whole file: prefix sums of the counts.
+	std::vector<size_t> positionBase(chunks + 1, 0), uvBase(chunks + 1, 0), normalBase(chunks + 1, 0), cornerBase(chunks + 1, 0);
+	std::vector<unsigned int> lineBase(chunks + 1, 0);
+	for (size_t c = 0; c < chunks; c++) {
+		if (errors[c]) {
+			printf("%s:%u : %s\n", name, lineBase[c] + lines[c], errors[c]);
+			return false;
+		}
+		lineBase[c + 1] = lineBase[c] + lines[c];
+		positionBase[c + 1] = positionBase[c] + parts[c].positions.size();
+		uvBase[c + 1] = uvBase[c] + parts[c].uvs.size();
+		normalBase[c + 1] = normalBase[c] + parts[c].normals.size();
+		cornerBase[c + 1] = cornerBase[c] + parts[c].corners.size();
+	}
+
+	size_t firstPosition = out.positions.size(), firstUv = out.uvs.size();
+	size_t firstNormal = out.normals.size(), firstCorner = out.corners.size();
+	out.positions.resize(firstPosition + positionBase[chunks]);
+	out.uvs.resize(firstUv + uvBase[chunks]);
+	out.normals.resize(firstNormal + normalBase[chunks]);
+	out.corners.resize(firstCorner + cornerBase[chunks]);
+
+	//Copy every chunk into place. Positive indices are already global, the
+	//negative ones get the number of elements in the chunks before them added.
+	//badLine is the first line of each chunk with one that points before the
+	//file, which parseOBJ turns down as it reads.
+	std::vector<unsigned int> badLine(chunks, 0);
+	pool.parallelFor(0, chunks, 1, [&](size_t b, size_t e) {
+		for (size_t c = b; c < e; c++) {
+			ObjData& part = parts[c];
+			std::copy(part.positions.begin(), part.positions.end(), out.positions.begin() + firstPosition + positionBase[c]);
+			std::copy(part.uvs.begin(), part.uvs.end(), out.uvs.begin() + firstUv + uvBase[c]);
+			std::copy(part.normals.begin(), part.normals.end(), out.normals.begin() + firstNormal + normalBase[c]);
+			ObjCorner* corners = out.corners.data() + firstCorner + cornerBase[c];
+			std::copy(part.corners.begin(), part.corners.end(), corners);
+			for (size_t r = 0; r < relative[c].size(); r++) {
+				ObjCorner& corner = corners[relative[c][r].corner];
+				unsigned int components = relative[c][r].components;
+				bool good = true;
+				if (components & 1) good &= fixRelativeIndex(corner.v, firstPosition + positionBase[c], (components & 8) != 0);
+				if (components & 2) good &= fixRelativeIndex(corner.vt, firstUv + uvBase[c], (components & 16) != 0);
+				if (components & 4) good &= fixRelativeIndex(corner.vn, firstNormal + normalBase[c], (components & 32) != 0);
+				if (!good && badLine[c] == 0) badLine[c] = relative[c][r].line;
+			}
+			part = ObjData();
+		}
+	});
+	for (size_t c = 0; c < chunks; c++) {
+		if (badLine[c]) {
+			printf("%s:%u : %s\n", name, lineBase[c] + badLine[c], BAD_CORNER);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool buildIndexedMesh(
+	const ObjData& data,
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	const char* name
+) {
+	//Vertices made so far from each position, as linked lists through next,
+	//so finding the vertex for a corner is a walk over the few (usually 1-4)
+	//that share its position instead of a hash lookup.
+	const unsigned int none = ~0u;
+	const unsigned int base = (unsigned int)out_vertices.size();
+	std::vector<unsigned int> firstWithPosition(data.positions.size(), none);
+	std::vector<unsigned int> next;
+	std::vector<ObjCorner> vertexCorner;
+	next.reserve(data.positions.size());
+	vertexCorner.reserve(data.positions.size());
+	out_indices.reserve(out_indices.size() + data.corners.size());
+
+	for (size_t i = 0; i < data.corners.size(); i++) {
+		const ObjCorner& corner = data.corners[i];
+		if (corner.v >= data.positions.size() ||
+			(corner.vt != OBJ_NONE && corner.vt >= data.uvs.size()) ||
+			(corner.vn != OBJ_NONE && corner.vn >= data.normals.size())) {
+			printf("%s : a face uses a vertex, texture coordinate or normal the file doesn't have\n", name);
+			return false;
+		}
+
+		// Seen this combination before ? Then just point at it again.
+		unsigned int found = firstWithPosition[corner.v];
+		while (found != none && !(vertexCorner[found] == corner)) {
+			found = next[found];
+		}
+		if (found != none) {
+			out_indices.push_back(base + found);
+			continue;
+		}
+
+		unsigned int local = (unsigned int)vertexCorner.size();
+		vertexCorner.push_back(corner);
+		next.push_back(firstWithPosition[corner.v]);
+		firstWithPosition[corner.v] = local;
+
+		// Put the attributes in buffers
+		out_indices.push_back((unsigned int)out_vertices.size());
+		out_vertices.push_back(data.positions[corner.v]);
+		out_uvs.push_back(corner.vt != OBJ_NONE ? data.uvs[corner.vt] : glm::vec2(0.0f));
+		out_normals.push_back(corner.vn != OBJ_NONE ? data.normals[corner.vn] : glm::vec3(0.0f));
+	}
+	printf("%s : %u triangles, %u unique vertices out of %u corners\n", name,
+		(unsigned int)(data.corners.size() / 3), (unsigned int)vertexCorner.size(), (unsigned int)data.corners.size());
+	return true;
+}
+
+bool loadOBJ(
+	const char* path,
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	ThreadPool* pool
+) {
+	printf("Loading OBJ file %s...\n", path);
+
+	MappedFile file;
+	if (!file.open(path)) {
+		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
+		getchar();
+		return false;
+	}
+
+	ObjData data;
+	const char* text = (const char*)file.data();
+	if (pool ? !parseOBJParallel(text, file.size(), data, path, *pool) : !parseOBJ(text, file.size(), data, path)) return false;
+	return buildIndexedMesh(data, out_indices, out_vertices, out_uvs, out_normals, path);
+}
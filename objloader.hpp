@@ -0,0 +1,64 @@
+#ifndef OBJLOADER_HPP
+#define OBJLOADER_HPP
+
+#include <stddef.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+// Marks a face corner without a texture coordinate or normal (f 1//1, f 1).
+const unsigned int OBJ_NONE = ~0u;
+
+// One face corner of the OBJ file : 0-based position, uv and normal indices.
+struct ObjCorner {
+	unsigned int v, vt, vn;
+	bool operator==(const ObjCorner& o) const { return v == o.v && vt == o.vt && vn == o.vn; }
+};
+
+// Everything loadOBJ needs out of the file, before vertices are merged.
+// Polygons are already split into triangles, three corners each.
+struct ObjData {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<ObjCorner> corners;
+};
+
+// Parses OBJ text (v, vt, vn and f records, everything else is skipped).
+// Faces may be v, v/vt, v//vn or v/vt/vn with negative (relative) indices,
+// and polygons are fanned into triangles. The text doesn't need a terminating
+// NUL, so it can come straight from a mapped file. name is for error messages.
+bool parseOBJ(const char* text, size_t size, ObjData& out, const char* name);
+
+// parseOBJ on several threads: the text is cut into chunks at line starts,
+// each parsed into arrays of its own, then copied into out at offsets from
+// a prefix sum of the chunk counts, adding those offsets to negative indices.
+// chunks = 0 makes a few per thread so a slow chunk doesn't hold up the rest.
+bool parseOBJParallel(const char* text, size_t size, ObjData& out, const char* name, ThreadPool& pool, size_t chunks = 0);
+
+// Chunks are never smaller than this, below it threads cost more than they save.
+const size_t OBJ_MIN_CHUNK_BYTES = 1 << 20;
+
+// Merges corners with the same (v, vt, vn) into one vertex. out_indices holds
+// three indices per triangle into the out_ arrays, ready for glDrawElements.
+bool buildIndexedMesh(
+	const ObjData& data,
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	const char* name
+);
+
+// Maps the file and does both of the above, parsing on pool when given one.
+bool loadOBJ(
+	const char* path,
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	ThreadPool* pool = NULL
+);
+
+#endif
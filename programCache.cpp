@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <GL/glew.h>
+
+#include "programCache.hpp"
+#include "hash.hpp"
+#include "mappedFile.hpp"
+
+bool programBinariesSupported() {
+	if (!GLEW_ARB_get_program_binary) return false;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+uint64_t programDriverHash() {
+	std::string driver;
+	const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		const char* value = (const char*)glGetString(names[i]);
+		driver += value ? value : "";
+		driver += '\n';
+	}
+	return hashBytes(driver.data(), driver.size());
+}
+
+std::string programCachePath(const char* vertexPath, const char* fragmentPath) {
+	//Next to the vertex shader, the fragment shader's directory left out.
+	const char* fragmentName = fragmentPath;
+	for (const char* p = fragmentPath; *p; p++) {
+		if (*p == '/' || *p == '\\') fragmentName = p + 1;
+	}
+	return std::string(vertexPath) + "+" + fragmentName + ".progbin";
+}
+
+GLuint loadProgramBinary(const char* cachePath, uint64_t driverHash, uint64_t sourceHash) {
+	MappedFile file;
+	if (!file.open(cachePath) || file.size() < sizeof(ProgramCacheHeader)) return 0;
+	ProgramCacheHeader h;
+	memcpy(&h, file.data(), sizeof(h));
+	if (memcmp(h.magic, "SSPB", 4) != 0 || h.version != PROGRAM_CACHE_VERSION) return 0;
+	if (h.driverHash != driverHash || h.sourceHash != sourceHash) return 0;
+	if (h.binaryLength == 0 || h.dataOffset < sizeof(h) || h.dataOffset + h.binaryLength > file.size()) return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, (GLenum)h.binaryFormat, file.data() + h.dataOffset, (GLsizei)h.binaryLength);
+	//A format the driver no longer knows is an error, not just a failed link.
+	while (glGetError() != GL_NO_ERROR) {}
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+bool saveProgramBinary(const char* cachePath, GLuint program, uint64_t driverHash, uint64_t sourceHash) {
+	GLint linked = GL_FALSE, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE) return false;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return false;
+
+	std::vector<unsigned char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, &binary[0]);
+	if (written <= 0) return false;
+
+	ProgramCacheHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "SSPB", 4);
+	h.version = PROGRAM_CACHE_VERSION;
+	h.driverHash = driverHash;
+	h.sourceHash = sourceHash;
+	h.binaryFormat = format;
+	h.binaryLength = (uint32_t)written;
+	h.dataOffset = sizeof(h);
+
+	//Same as the mesh cache: temporary name, then rename.
+	std::string temp = std::string(cachePath) + ".tmp";
+	FILE* file = fopen(temp.c_str(), "wb");
+	if (file == NULL) return false;
+	bool ok = fwrite(&h, sizeof(h), 1, file) == 1 && fwrite(&binary[0], 1, written, file) == (size_t)written;
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		remove(temp.c_str());
+		return false;
+	}
+	remove(cachePath);
+	return rename(temp.c_str(), cachePath) == 0;
+}
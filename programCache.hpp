@@ -0,0 +1,51 @@
+#ifndef PROGRAMCACHE_HPP
+#define PROGRAMCACHE_HPP
+
+// Linked shader programs saved with glGetProgramBinary, written next to the
+// vertex shader as <vertex>+<fragment>.progbin the first time the pair is
+// linked. Later runs hand the blob back to glProgramBinary and skip compiling
+// and linking altogether.
+//
+// A binary is only good for the driver that made it, so the file remembers a
+// hash of the GL vendor, renderer and version strings as well as the hash of
+// both sources. When either changed, or the driver turns the binary down
+// anyway (it may, after an update that kept the version string), the program
+// is compiled from source as before and the file written again.
+//
+// File layout (little endian):
+//   ProgramCacheHeader
+//   binaryLength bytes of driver blob at header.dataOffset
+#include <stdint.h>
+#include <string>
+#include <GL/glew.h>
+
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+	char magic[4];       // "SSPB"
+	uint32_t version;
+	uint64_t driverHash; // programDriverHash()
+	uint64_t sourceHash; // hashBytes of vertex source + '\0' + fragment source
+	uint32_t binaryFormat;
+	uint32_t binaryLength;
+	uint64_t dataOffset;
+};
+
+// False when the context can't save programs (no ARB_get_program_binary, or
+// no binary formats, like Mesa with its shader cache turned off).
+bool programBinariesSupported();
+
+// Identifies the driver binaries are good for. Needs a current context.
+uint64_t programDriverHash();
+
+std::string programCachePath(const char* vertexPath, const char* fragmentPath);
+
+// A linked program from the cache file, 0 when there is no usable file or
+// the driver won't take the binary.
+GLuint loadProgramBinary(const char* cachePath, uint64_t driverHash, uint64_t sourceHash);
+
+// Saves a successfully linked program. False if it isn't linked, the driver
+// gives no binary or the file can't be written.
+bool saveProgramBinary(const char* cachePath, GLuint program, uint64_t driverHash, uint64_t sourceHash);
+
+#endif
@@ -0,0 +1,689 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <string>
+#include <GL/glew.h>
+
+#include "resourceManager.hpp"
+#include "cookedTexture.hpp"
+#include "mappedFile.hpp"
+#include "meshCache.hpp"
+#include "mipChain.hpp"
+#include "programCache.hpp"
+#include "shader.hpp"
+#include "textureStreamer.hpp"
+#include "threadPool.hpp"
+#include "timeline.hpp"
+#include "vertexFormat.hpp"
+
+//Mips are built on the loader threads, not by the driver on the GL thread.
+static const MipFilter TEXTURE_MIP_FILTER = MIP_KAISER;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Mesh::release() {
+	if (vertexArray) glDeleteVertexArrays(1, &vertexArray);
+	if (vertexBuffer) glDeleteBuffers(1, &vertexBuffer);
+	if (elementBuffer) glDeleteBuffers(1, &elementBuffer);
+	vertexArray = 0;
+	vertexBuffer = 0;
+	elementBuffer = 0;
+}
+
+void Mesh::setAttributes() const {
+	// Vertex buffer : positions, UVs and normals, interleaved
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+	// 1rst attribute : positions, half floats
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(
+		0,                                      // attribute
+		3,                                      // size
+		GL_HALF_FLOAT,                          // type
+		GL_FALSE,                               // normalized?
+		sizeof(PackedVertex),                   // stride
+		(void*)offsetof(PackedVertex, position) // array buffer offset
+	);
+
+	// 2nd attribute : UVs, 0..65535 read as 0..1
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(
+		1,                                      // attribute
+		2,                                      // size
+		GL_UNSIGNED_SHORT,                      // type
+		GL_TRUE,                                // normalized?
+		sizeof(PackedVertex),                   // stride
+		(void*)offsetof(PackedVertex, uv)       // array buffer offset
+	);
+
+	// 3rd attribute : octahedral normals, -32767..32767 read as -1..1
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(
+		2,                                      // attribute
+		2,                                      // size
+		GL_SHORT,                               // type
+		GL_TRUE,                                // normalized?
+		sizeof(PackedVertex),                   // stride
+		(void*)offsetof(PackedVertex, normal)   // array buffer offset
+	);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+}
+
+size_t Mesh::gpuBytes() const {
+	return vertexCount * sizeof(PackedVertex) + indexCount * sizeof(unsigned int);
+}
+
+void Texture::release() {
+	if (id) glDeleteTextures(1, &id);
+	id = 0;
+}
+
+size_t Texture::gpuBytes() const {
+	if (compressedBytes) return compressedBytes;
+	//The mip chain adds a third on top of level 0.
+	return (size_t)width * height * channels * layers * 4 / 3;
+}
+
+//A program that is still being compiled, and what to do once it's linked.
+struct PendingProgram {
+	ProgramBuild build;
+	std::string binaryPath; //Empty when the driver can't save programs.
+	uint64_t driverHash, sourceHash;
+	Timeline* timeline;
+	std::chrono::steady_clock::time_point submitted;
+};
+
+Program::Program() : id(0), linked(false), waitMilliseconds(0.0) {
+}
+
+Program::~Program() {
+	release();
+}
+
+void Program::release() {
+	if (pending) {
+		if (pending->build.vertexShader) glDeleteShader(pending->build.vertexShader);
+		if (pending->build.fragmentShader) glDeleteShader(pending->build.fragmentShader);
+		pending.reset();
+	}
+	if (id) glDeleteProgram(id);
+	id = 0;
+	linked = false;
+	uniforms.clear();
+}
+
+bool Program::ready() const {
+	return !pending || programBuildDone(pending->build);
+}
+
+bool Program::finish() {
+	if (!pending) return linked;
+	PendingProgram& job = *pending;
+	auto start = std::chrono::steady_clock::now();
+	{
+		Timeline::Scope scope(job.timeline, "link " + job.build.vertexName + " + " + job.build.fragmentName);
+		linked = finishProgram(job.build);
+	}
+	waitMilliseconds = millisecondsSince(start);
+
+	const char* how = "compiled";
+	if (linked && !job.binaryPath.empty()) {
+		how = saveProgramBinary(job.binaryPath.c_str(), id, job.driverHash, job.sourceHash) ?
+			"compiled, program binary written" : "compiled, no program binary";
+	}
+	printf("%s + %s : %s, %.2f ms after it was asked for, %.2f ms of it waiting\n", job.build.vertexName.c_str(),
+		job.build.fragmentName.c_str(), how, millisecondsSince(job.submitted), waitMilliseconds);
+	pending.reset();
+	return linked;
+}
+
+GLint Program::uniform(const char* name) {
+	finish();
+	std::map<std::string, GLint>::iterator it = uniforms.find(name);
+	if (it != uniforms.end()) return it->second;
+	GLint location = glGetUniformLocation(id, name);
+	uniforms[name] = location;
+	return location;
+}
+
+// A texture between request and upload. The file stays mapped until it's
+// decoded. pixels then holds the whole mip chain. When the streamer's ring is
+// persistently mapped and had room, the decoder copies the chain into it and
+// frees its own buffer right away; otherwise pixels live until upload copies
+// them into the ring.
+struct ResourceManager::PendingTexture {
+	PendingTexture() : layer(-1), pixels(NULL), width(0), height(0), channels(0), decodeMilliseconds(0.0), mipMilliseconds(0.0),
+		reserved(false), inRing(false), ringOffset(0), ringPointer(NULL) {}
+
+	std::string path;
+	TextureHandle texture;
+	int layer;                  // Of texture when it's an array, else -1.
+	MappedFile file;
+	unsigned char* pixels;
+	int width, height, channels;
+	double decodeMilliseconds, mipMilliseconds;
+	std::future<void> decoded;
+
+	bool reserved;              // ringOffset is a reservation in the streamer.
+	bool inRing;                // The pixels are already there.
+	size_t ringOffset;
+	unsigned char* ringPointer; // Where the decoder may write them, or NULL.
+};
+
+ResourceManager::ResourceManager(ThreadPool* pool, Timeline* timeline) : pool(pool), timeline(timeline),
+	streamer(new TextureStreamer()), programBinaries(-1), parallelCompile(false), driverHash(0), programBinaryLoads(0) {
+}
+
+ResourceManager::~ResourceManager() {
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending[i]->decoded.valid()) pending[i]->decoded.wait();
+		stbi_image_free(pending[i]->pixels);
+	}
+}
+
+MeshHandle ResourceManager::mesh(const char* objPath) {
+	meshes.requests++;
+	MeshHandle mesh = meshes.byPath(objPath);
+	if (mesh) return mesh;
+
+	Timeline::Scope scope(timeline, std::string("mesh ") + objPath);
+	auto start = std::chrono::steady_clock::now();
+	CachedMesh cached;
+	if (!loadMesh(objPath, cached, pool)) return MeshHandle();
+	mesh = meshes.byHash(cached.sourceHash);
+	if (mesh) {
+		//Another path, same OBJ.
+		meshes.paths[objPath] = mesh;
+		return mesh;
+	}
+
+	mesh = std::make_shared<Mesh>();
+	mesh->vertexCount = cached.vertexCount;
+	mesh->indexCount = cached.indexCount;
+	mesh->uvTransform = cached.uvTransform;
+	for (size_t i = 0; i < cached.vertexCount; i++) {
+		const uint16_t* position = cached.vertices[i].position;
+		glm::vec3 p(halfToFloat(position[0]), halfToFloat(position[1]), halfToFloat(position[2]));
+		mesh->radius = std::max(mesh->radius, glm::length(p));
+	}
+
+	//The element buffer binding below goes into the bound vertex array. Give
+	//the mesh its own first, and put the caller's back afterwards.
+	GLint boundVertexArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &boundVertexArray);
+	glGenVertexArrays(1, &mesh->vertexArray);
+	glBindVertexArray(mesh->vertexArray);
+
+	// Load it into a VBO : positions, UVs and normals interleaved
+	glGenBuffers(1, &mesh->vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, cached.vertexCount * sizeof(PackedVertex), cached.vertices, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &mesh->elementBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->elementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, cached.indexCount * sizeof(unsigned int), cached.indices, GL_STATIC_DRAW);
+
+	mesh->setAttributes();
+	glBindVertexArray((GLuint)boundVertexArray);
+
+	printVertexMemory(objPath, cached.vertexCount);
+	meshes.add(objPath, cached.sourceHash, mesh);
+	meshes.loads++;
+	meshes.loadMilliseconds += millisecondsSince(start);
+	return mesh;
+}
+
+void ResourceManager::decode(PendingTexture& job, Timeline* timeline) {
+	int width = job.width, height = job.height, channels = job.channels;
+	{
+		Timeline::Scope scope(timeline, "decode " + job.path);
+		auto start = std::chrono::steady_clock::now();
+		job.pixels = stbi_load_from_memory(job.file.data(), (int)job.file.size(), &job.width, &job.height, &job.channels, 0);
+		if (!job.pixels) printf("Failed to load texture %s : %s\n", job.path.c_str(), stbi_failure_reason());
+		job.file.close();
+		job.decodeMilliseconds = millisecondsSince(start);
+	}
+	if (!job.pixels) return;
+
+	{
+		Timeline::Scope scope(timeline, "mips " + job.path);
+		auto start = std::chrono::steady_clock::now();
+		//stb_image allocates with plain malloc, so its buffer can grow to hold the chain.
+		size_t chainBytes = mipChainBytes(job.width, job.height, job.channels);
+		unsigned char* chain = (unsigned char*)realloc(job.pixels, chainBytes);
+		if (!chain) {
+			printf("Out of memory for the mips of %s\n", job.path.c_str());
+			stbi_image_free(job.pixels);
+			job.pixels = NULL;
+			return;
+		}
+		job.pixels = chain;
+		buildMipChain(job.pixels, job.width, job.height, job.channels, TEXTURE_MIP_FILTER);
+
+		//Straight into the pixel buffer the upload reads from, no CPU copy kept around.
+		if (job.ringPointer && width == job.width && height == job.height && channels == job.channels) {
+			memcpy(job.ringPointer, job.pixels, chainBytes);
+			stbi_image_free(job.pixels);
+			job.pixels = NULL;
+			job.inRing = true;
+		}
+		job.mipMilliseconds = millisecondsSince(start);
+	}
+}
+
+TextureHandle ResourceManager::texture(const char* imagePath) {
+	return requestTexture(imagePath, false);
+}
+
+TextureHandle ResourceManager::textureAsync(const char* imagePath) {
+	return requestTexture(imagePath, pool != NULL);
+}
+
+TextureHandle ResourceManager::requestTexture(const char* imagePath, bool async) {
+	textures.requests++;
+	TextureHandle texture = textures.byPath(imagePath);
+	if (texture) return texture;
+
+	std::shared_ptr<PendingTexture> job = std::make_shared<PendingTexture>();
+	job->path = imagePath;
+	if (!job->file.open(imagePath) || job->file.size() == 0) {
+		printf("Failed to load texture %s\n", imagePath);
+		return TextureHandle();
+	}
+	uint64_t hash = hashBytes(job->file.data(), job->file.size());
+	texture = textures.byHash(hash);
+	if (texture) {
+		textures.paths[imagePath] = texture;
+		return texture;
+	}
+
+	//Cooked offline: nothing to decode, the mapped levels go straight to GL.
+	CookedTexture cooked;
+	if (openCookedTexture(cookedTexturePath(imagePath).c_str(), hash, job->file.size(), cooked)) {
+		texture = std::make_shared<Texture>();
+		if (uploadCooked(imagePath, &cooked, 1, *texture)) {
+			textures.add(imagePath, hash, texture);
+			return texture;
+		}
+	}
+
+	//In the table right away, so asking again while it decodes shares it too.
+	texture = std::make_shared<Texture>();
+	job->texture = texture;
+	textures.add(imagePath, hash, texture);
+
+	startDecode(job, async);
+	if (!async && !texture->id) {
+		textures.paths.erase(imagePath);
+		textures.hashes.erase(hash);
+		return TextureHandle();
+	}
+	return texture;
+}
+
+TextureHandle ResourceManager::textureArray(const std::vector<std::string>& imagePaths) {
+	textures.requests++;
+	std::string key;
+	for (size_t i = 0; i < imagePaths.size(); i++) key += imagePaths[i] + "\n";
+	TextureHandle texture = textures.byPath(key);
+	if (texture || imagePaths.empty()) return texture;
+
+	//Every layer's size comes from its header, the storage is made before decoding.
+	std::vector<std::shared_ptr<PendingTexture> > jobs;
+	std::vector<uint64_t> hashes;
+	for (size_t i = 0; i < imagePaths.size(); i++) {
+		std::shared_ptr<PendingTexture> job = std::make_shared<PendingTexture>();
+		job->path = imagePaths[i];
+		job->layer = (int)i;
+		if (!job->file.open(job->path.c_str()) || job->file.size() == 0) {
+			printf("Failed to load texture %s\n", job->path.c_str());
+			return TextureHandle();
+		}
+		if (!stbi_info_from_memory(job->file.data(), (int)job->file.size(), &job->width, &job->height, &job->channels)) {
+			printf("Failed to load texture %s : %s\n", job->path.c_str(), stbi_failure_reason());
+			return TextureHandle();
+		}
+		const PendingTexture& first = jobs.empty() ? *job : *jobs[0];
+		if (job->width != first.width || job->height != first.height || job->channels != first.channels) {
+			printf("%s : %dx%d, %d channels, but %s is %dx%d, %d channels. Layers of a texture array have to match.\n",
+				job->path.c_str(), job->width, job->height, job->channels, first.path.c_str(), first.width, first.height, first.channels);
+			return TextureHandle();
+		}
+		hashes.push_back(hashBytes(job->file.data(), job->file.size()));
+		jobs.push_back(job);
+	}
+	uint64_t hash = hashBytes(&hashes[0], hashes.size() * sizeof(uint64_t));
+	texture = textures.byHash(hash);
+	if (texture) {
+		textures.paths[key] = texture;
+		return texture;
+	}
+
+	texture = std::make_shared<Texture>();
+	texture->target = GL_TEXTURE_2D_ARRAY;
+	texture->layers = (int)jobs.size();
+
+	std::unique_ptr<CookedTexture[]> cooked(new CookedTexture[jobs.size()]);
+	bool allCooked = true;
+	for (size_t i = 0; i < jobs.size() && allCooked; i++) {
+		allCooked = openCookedTexture(cookedTexturePath(jobs[i]->path.c_str()).c_str(), hashes[i], jobs[i]->file.size(), cooked[i]);
+	}
+	std::string name;
+	for (size_t i = 0; i < jobs.size(); i++) name += (i ? "," : "") + jobs[i]->path;
+	if (allCooked && uploadCooked(name, cooked.get(), jobs.size(), *texture)) {
+		textures.add(key, hash, texture);
+		return texture;
+	}
+
+	texture->width = jobs[0]->width;
+	texture->height = jobs[0]->height;
+	texture->channels = jobs[0]->channels;
+	static const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	GLenum format = formats[texture->channels];
+	glGenTextures(1, &texture->id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+	for (int level = 0, levels = mipLevelCount(texture->width, texture->height); level < levels; level++) {
+		int w = std::max(1, texture->width >> level), h = std::max(1, texture->height >> level);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, w, h, texture->layers, 0, format, GL_UNSIGNED_BYTE, NULL);
+	}
+	textures.add(key, hash, texture);
+	textures.loads++;
+
+	for (size_t i = 0; i < jobs.size(); i++) {
+		jobs[i]->texture = texture;
+		startDecode(jobs[i], pool != NULL);
+	}
+	return texture;
+}
+
+void ResourceManager::startDecode(const std::shared_ptr<PendingTexture>& job, bool async) {
+	if (!async) {
+		decode(*job, timeline);
+		upload(*job, true);
+		return;
+	}
+
+	//The header says how big the pixels will be, so room in a persistently
+	//mapped ring can be claimed now and the decoder can write into it.
+	if (streamer->persistent() &&
+		stbi_info_from_memory(job->file.data(), (int)job->file.size(), &job->width, &job->height, &job->channels) &&
+		streamer->reserve(mipChainBytes(job->width, job->height, job->channels), job->ringOffset)) {
+		job->reserved = true;
+		job->ringPointer = streamer->writePointer(job->ringOffset);
+	}
+	Timeline* t = timeline;
+	job->decoded = pool->submit([job, t]() { decode(*job, t); });
+	pending.push_back(job);
+}
+
+bool ResourceManager::upload(PendingTexture& job, bool mustFinish) {
+	Texture& texture = *job.texture;
+	bool layer = job.layer >= 0;
+	if (layer && job.pixels && (job.width != texture.width || job.height != texture.height || job.channels != texture.channels)) {
+		//The header said otherwise when the array was made.
+		printf("Failed to load texture %s : doesn't match the other layers\n", job.path.c_str());
+		stbi_image_free(job.pixels);
+		job.pixels = NULL;
+	}
+	if (!job.pixels && !job.inRing) {
+		//Decoding failed, the texture (or layer) stays empty.
+		if (job.reserved) streamer->cancel(job.ringOffset);
+		return true;
+	}
+
+	size_t bytes = mipChainBytes(job.width, job.height, job.channels);
+	if (!job.reserved && streamer->reserve(bytes, job.ringOffset)) job.reserved = true;
+	//Ring full: during the game try again next frame rather than stall.
+	if (!job.reserved && !mustFinish && bytes <= streamer->capacity()) return false;
+
+	Timeline::Scope scope(timeline, "upload " + job.path);
+	auto start = std::chrono::steady_clock::now();
+
+	static const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	GLenum format = formats[job.channels];
+	if (!layer) {
+		texture.width = job.width;
+		texture.height = job.height;
+		texture.channels = job.channels;
+		glGenTextures(1, &texture.id);
+	}
+
+	const char* path;
+	if (job.reserved) {
+		streamer->upload(texture.id, job.ringOffset, job.width, job.height, format, job.inRing ? NULL : job.pixels, job.layer);
+		path = job.inRing ? "decoded into mapped PBO" : "copied to PBO";
+	}
+	else {
+		//Bigger than the whole ring, or it's full and we can't wait.
+		// "Bind" the newly created texture : all future texture functions will modify this texture
+		glBindTexture(texture.target, texture.id);
+		// Give the image to OpenGL. Rows of 3 byte pixels aren't 4 byte aligned.
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		const unsigned char* level = job.pixels;
+		for (int i = 0, levels = mipLevelCount(job.width, job.height); i < levels; i++) {
+			int w = std::max(1, job.width >> i), h = std::max(1, job.height >> i);
+			if (layer) glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, job.layer, w, h, 1, format, GL_UNSIGNED_BYTE, level);
+			else glTexImage2D(GL_TEXTURE_2D, i, format, w, h, 0, format, GL_UNSIGNED_BYTE, level);
+			level += (size_t)w * h * job.channels;
+		}
+		path = "from client memory";
+	}
+	stbi_image_free(job.pixels);
+	job.pixels = NULL;
+
+	double uploadMilliseconds = millisecondsSince(start);
+	//An array counts as one load, when it's made.
+	if (!layer) textures.loads++;
+	textures.loadMilliseconds += job.decodeMilliseconds + job.mipMilliseconds + uploadMilliseconds;
+	char what[32] = "texture";
+	if (layer) snprintf(what, sizeof(what), "array layer %d", job.layer);
+	printf("%s : %dx%d %s, %d channels, decoded in %.2f ms, mips in %.2f ms, uploaded in %.2f ms (%s)\n", job.path.c_str(),
+		job.width, job.height, what, job.channels, job.decodeMilliseconds, job.mipMilliseconds, uploadMilliseconds, path);
+	return true;
+}
+
+bool ResourceManager::uploadCooked(const std::string& name, const CookedTexture* cooked, size_t layers, Texture& texture) {
+	const CookedTextureHeader& first = cooked[0].header;
+	TextureCodec codec = (TextureCodec)first.codec;
+	for (size_t i = 1; i < layers; i++) {
+		const CookedTextureHeader& h = cooked[i].header;
+		if (h.codec != first.codec || h.width != first.width || h.height != first.height || h.levelCount != first.levelCount) {
+			printf("%s : cooked layers don't match, decoding instead\n", name.c_str());
+			return false;
+		}
+	}
+	GLenum format;
+	if (codec == TEXTURE_BC1 && GLEW_EXT_texture_compression_s3tc) format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if (codec == TEXTURE_BC7 && (GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2)) format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+	else {
+		printf("%s : GPU can't sample %s, decoding instead\n", name.c_str(), codecName(codec));
+		return false;
+	}
+
+	Timeline::Scope scope(timeline, "cooked " + name);
+	auto start = std::chrono::steady_clock::now();
+	texture.width = (int)first.width;
+	texture.height = (int)first.height;
+	texture.channels = codec == TEXTURE_BC1 ? 3 : 4;
+	texture.compressedBytes = 0;
+	for (size_t i = 0; i < layers; i++) texture.compressedBytes += cooked[i].totalBytes();
+
+	glGenTextures(1, &texture.id);
+	glBindTexture(texture.target, texture.id);
+	int width = texture.width, height = texture.height;
+	for (size_t level = 0; level < first.levelCount; level++) {
+		if (texture.target == GL_TEXTURE_2D_ARRAY) {
+			GLsizei levelBytes = (GLsizei)cooked[0].levels[level].size;
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, format, width, height, (GLsizei)layers, 0,
+				levelBytes * (GLsizei)layers, NULL);
+			for (size_t i = 0; i < layers; i++) {
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, (GLint)i, width, height, 1, format,
+					levelBytes, cooked[i].levelData(level));
+			}
+		}
+		else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, width, height, 0,
+				(GLsizei)cooked[0].levels[level].size, cooked[0].levelData(level));
+		}
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, (GLint)first.levelCount - 1);
+
+	double uploadMilliseconds = millisecondsSince(start);
+	textures.loads++;
+	textures.loadMilliseconds += uploadMilliseconds;
+	printf("%s : %dx%d texture%s, %s, %u levels from cooked files, uploaded in %.2f ms\n", name.c_str(), texture.width,
+		texture.height, texture.target == GL_TEXTURE_2D_ARRAY ? " array" : "", codecName(codec), first.levelCount, uploadMilliseconds);
+	return true;
+}
+
+void ResourceManager::uploadDecoded() {
+	size_t kept = 0;
+	for (size_t i = 0; i < pending.size(); i++) {
+		bool ready = pending[i]->decoded.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		if (!ready || !upload(*pending[i], false)) {
+			pending[kept++] = pending[i];
+		}
+	}
+	pending.resize(kept);
+
+	std::map<uint64_t, std::weak_ptr<Program> >::iterator it;
+	for (it = programs.hashes.begin(); it != programs.hashes.end(); ++it) {
+		ProgramHandle program = it->second.lock();
+		if (program && program->pending && program->ready()) program->finish();
+	}
+}
+
+void ResourceManager::finishLoads() {
+	Timeline::Scope scope(timeline, "wait for decoding");
+	for (size_t i = 0; i < pending.size(); i++) {
+		pending[i]->decoded.wait();
+		upload(*pending[i], true);
+	}
+	pending.clear();
+}
+
+ProgramHandle ResourceManager::program(const char* vertexPath, const char* fragmentPath) {
+	programs.requests++;
+	std::string key = std::string(vertexPath) + "\n" + fragmentPath;
+	ProgramHandle program = programs.byPath(key);
+	if (program) return program;
+
+	Timeline::Scope scope(timeline, std::string("program ") + vertexPath);
+	auto start = std::chrono::steady_clock::now();
+	std::string vertexCode, fragmentCode;
+	if (!readShaderFile(vertexPath, vertexCode) || !readShaderFile(fragmentPath, fragmentCode)) {
+		printf("Impossible to open %s or %s. Are you in the right directory ?\n", vertexPath, fragmentPath);
+		return ProgramHandle();
+	}
+	std::string both = vertexCode + '\0' + fragmentCode;
+	uint64_t hash = hashBytes(both.data(), both.size());
+	program = programs.byHash(hash);
+	if (program) {
+		programs.paths[key] = program;
+		return program;
+	}
+
+	//Asked once the context is there, not when constructed.
+	if (programBinaries < 0) {
+		programBinaries = programBinariesSupported() ? 1 : 0;
+		if (programBinaries) driverHash = programDriverHash();
+		parallelCompile = enableParallelShaderCompile();
+	}
+
+	program = std::make_shared<Program>();
+	std::string cachePath = programCachePath(vertexPath, fragmentPath);
+	if (programBinaries) program->id = loadProgramBinary(cachePath.c_str(), driverHash, hash);
+	if (program->id) {
+		program->linked = true;
+		programBinaryLoads++;
+		printf("%s + %s : from program binary, %.2f ms\n", vertexPath, fragmentPath, millisecondsSince(start));
+	}
+	else {
+		//Only started here, the program finishes when it's first used.
+		std::unique_ptr<PendingProgram> job(new PendingProgram());
+		job->binaryPath = programBinaries ? cachePath : std::string();
+		job->driverHash = driverHash;
+		job->sourceHash = hash;
+		job->timeline = timeline;
+		job->submitted = start;
+		submitProgram(vertexPath, vertexCode, fragmentPath, fragmentCode, job->build);
+		program->id = job->build.program;
+		program->pending = std::move(job);
+	}
+
+	programs.add(key, hash, program);
+	programs.loads++;
+	programs.loadMilliseconds += millisecondsSince(start);
+	return program;
+}
+
+template <class T>
+static void releaseTable(ResourceTable<T>& table) {
+	typename std::map<uint64_t, std::weak_ptr<T> >::iterator it;
+	for (it = table.hashes.begin(); it != table.hashes.end(); ++it) {
+		std::shared_ptr<T> resource = it->second.lock();
+		if (resource) resource->release();
+	}
+	table.paths.clear();
+	table.hashes.clear();
+}
+
+void ResourceManager::releaseAll() {
+	//Decoders may still be writing into the ring.
+	for (size_t i = 0; i < pending.size(); i++) {
+		pending[i]->decoded.wait();
+		stbi_image_free(pending[i]->pixels);
+	}
+	pending.clear();
+	streamer->release();
+	releaseTable(meshes);
+	releaseTable(textures);
+	releaseTable(programs);
+}
+
+static size_t gpuBytesOf(const Mesh& mesh) { return mesh.gpuBytes(); }
+static size_t gpuBytesOf(const Texture& texture) { return texture.gpuBytes(); }
+static size_t gpuBytesOf(const Program&) { return 0; } //Drivers don't say.
+
+template <class T>
+static void printTable(const char* kind, const ResourceTable<T>& table) {
+	unsigned int alive = 0;
+	size_t gpuBytes = 0;
+	typename std::map<uint64_t, std::weak_ptr<T> >::const_iterator it;
+	for (it = table.hashes.begin(); it != table.hashes.end(); ++it) {
+		std::shared_ptr<T> resource = it->second.lock();
+		if (!resource) continue;
+		alive++;
+		gpuBytes += gpuBytesOf(*resource);
+	}
+	printf("  %-9s %3u requested, %3u loaded, %3u alive, %8.1f KB, %7.2f ms loading\n",
+		kind, table.requests, table.loads, alive, gpuBytes / 1024.0, table.loadMilliseconds);
+}
+
+void ResourceManager::printStats() const {
+	printf("Resources :\n");
+	printTable("meshes", meshes);
+	printTable("textures", textures);
+	printTable("programs", programs);
+	if (programBinaries > 0) printf("  %u of the programs from binaries\n", programBinaryLoads);
+	else if (programBinaries == 0) printf("  no program binaries with this driver\n");
+	double waited = 0.0;
+	std::map<uint64_t, std::weak_ptr<Program> >::const_iterator it;
+	for (it = programs.hashes.begin(); it != programs.hashes.end(); ++it) {
+		ProgramHandle program = it->second.lock();
+		if (program) waited += program->waitMilliseconds;
+	}
+	printf("  %.2f ms waiting for programs to link, %s\n", waited,
+		parallelCompile ? "compiled on the driver's threads" : "no parallel shader compile");
+}
@@ -0,0 +1,182 @@
+#ifndef RESOURCEMANAGER_HPP
+#define RESOURCEMANAGER_HPP
+
+// Loads meshes, textures and shader programs once and hands out shared,
+// reference counted handles to them. Asking again for the same path, or for
+// another path with the same contents, returns the GL objects already made,
+// so GPU memory and load time grow with the number of distinct assets, not
+// with the number of things drawn with them. The GL objects are deleted when
+// the last handle to them goes away.
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+class Timeline;
+class TextureStreamer;
+struct CookedTexture;
+
+struct Mesh {
+	Mesh() : vertexBuffer(0), elementBuffer(0), vertexArray(0), vertexCount(0), indexCount(0), uvTransform(0.0f, 0.0f, 1.0f, 1.0f), radius(0.0f) {}
+	~Mesh() { release(); }
+	void release();
+	size_t gpuBytes() const;
+
+	// Points attributes 0 to 2 at the vertex buffer and binds the element
+	// buffer, into whatever vertex array is bound. For vertex arrays that
+	// add attributes of their own (instances); vertexArray has these alone.
+	void setAttributes() const;
+
+	GLuint vertexBuffer;  // PackedVertex, interleaved
+	GLuint elementBuffer; // unsigned int indices
+	GLuint vertexArray;   // Both of the above, ready to draw
+	size_t vertexCount;
+	size_t indexCount;
+	glm::vec4 uvTransform;
+	float radius;         // Of the sphere around the origin that holds every vertex, for culling
+};
+
+struct Texture {
+	Texture() : id(0), target(GL_TEXTURE_2D), width(0), height(0), channels(0), layers(1), compressedBytes(0) {}
+	~Texture() { release(); }
+	void release();
+	size_t gpuBytes() const;
+
+	GLuint id;
+	GLenum target; // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY from textureArray()
+	int width, height, channels;
+	int layers;
+	size_t compressedBytes; // Whole mip chain (all layers) when it came from cooked files, else 0.
+};
+
+struct PendingProgram;
+
+struct Program {
+	Program();
+	~Program();
+	void release();
+
+	// ResourceManager::program() only starts the compile and link. This waits
+	// for them if they're still going on, the first uniform() does it too, so
+	// it's the first use that waits. False when the program didn't link.
+	bool finish();
+	// True when finish() wouldn't wait.
+	bool ready() const;
+
+	// Location of a uniform, asked from GL only the first time.
+	GLint uniform(const char* name);
+
+	GLuint id; // There at once; GL itself waits for the link when it's used early.
+	std::map<std::string, GLint> uniforms;
+	bool linked;
+	double waitMilliseconds; // Spent in finish() waiting for the driver.
+	std::unique_ptr<PendingProgram> pending; // Until finish().
+};
+
+typedef std::shared_ptr<Mesh> MeshHandle;
+typedef std::shared_ptr<Texture> TextureHandle;
+typedef std::shared_ptr<Program> ProgramHandle;
+
+// Live resources of one kind, by path and by content hash. Holds weak
+// references only, the handles out there decide how long things live.
+template <class T>
+struct ResourceTable {
+	ResourceTable() : requests(0), loads(0), loadMilliseconds(0.0) {}
+
+	std::shared_ptr<T> byPath(const std::string& path) {
+		typename std::map<std::string, std::weak_ptr<T> >::iterator it = paths.find(path);
+		return it != paths.end() ? it->second.lock() : std::shared_ptr<T>();
+	}
+	std::shared_ptr<T> byHash(uint64_t hash) {
+		typename std::map<uint64_t, std::weak_ptr<T> >::iterator it = hashes.find(hash);
+		return it != hashes.end() ? it->second.lock() : std::shared_ptr<T>();
+	}
+	void add(const std::string& path, uint64_t hash, const std::shared_ptr<T>& resource) {
+		paths[path] = resource;
+		hashes[hash] = resource;
+	}
+
+	std::map<std::string, std::weak_ptr<T> > paths;
+	std::map<uint64_t, std::weak_ptr<T> > hashes;
+	unsigned int requests; // Handles asked for.
+	unsigned int loads;    // Times something was actually loaded.
+	double loadMilliseconds;
+};
+
+class ResourceManager {
+public:
+	// Meshes that miss the mesh cache are parsed on pool and textures are
+	// decoded on it, when given one. Loads are added to timeline if given.
+	explicit ResourceManager(ThreadPool* pool = NULL, Timeline* timeline = NULL);
+	~ResourceManager(); // Waits for decoding still going on.
+
+	// Empty handles when the file can't be loaded. Images with an up to date
+	// cooked file next to them (textureCook) are uploaded from that instead.
+	MeshHandle mesh(const char* objPath);
+	TextureHandle texture(const char* imagePath);
+	// Linked programs are saved as driver binaries where the driver can, and
+	// later runs load those instead of compiling (programCache.hpp). Otherwise
+	// the compile is only started here, see Program::finish(), so ask for the
+	// programs early and they build while the rest loads.
+	ProgramHandle program(const char* vertexPath, const char* fragmentPath);
+
+	// Like texture(), but the image is decoded on the pool and the call returns
+	// at once. The texture's id stays 0 until uploadDecoded() or finishLoads()
+	// has given it to GL, and stays 0 if decoding fails.
+	TextureHandle textureAsync(const char* imagePath);
+
+	// The images as the layers of one GL_TEXTURE_2D_ARRAY, in order, so bodies
+	// with different images can be drawn together and pick their layer in the
+	// shader. They must all have the same size and channel count. Decoded on
+	// the pool like textureAsync(), but the id is there at once: the storage is
+	// made here and each layer fills in when it's uploaded. Cooked files are
+	// used when every layer has one, with the same codec.
+	TextureHandle textureArray(const std::vector<std::string>& imagePaths);
+
+	// Uploads the textures that are done decoding, doesn't wait for the others.
+	// Finishes the programs that are done linking as well.
+	// GL calls only happen here, so call it on the thread with the context.
+	void uploadDecoded();
+
+	// Waits for all decoding and uploads the lot. Also on the GL thread.
+	void finishLoads();
+
+	size_t pendingLoads() const { return pending.size(); }
+
+	// Deletes the GL objects of everything still alive, handles and all.
+	// Must run while the GL context still exists.
+	void releaseAll();
+
+	// Requests against actual loads, and the GPU memory in use.
+	void printStats() const;
+
+private:
+	ResourceManager(const ResourceManager&);
+	ResourceManager& operator=(const ResourceManager&);
+
+	struct PendingTexture;
+	TextureHandle requestTexture(const char* imagePath, bool async);
+	void startDecode(const std::shared_ptr<PendingTexture>& job, bool async);
+	static void decode(PendingTexture& job, Timeline* timeline);
+	bool upload(PendingTexture& job, bool mustFinish);
+	bool uploadCooked(const std::string& name, const CookedTexture* cooked, size_t layers, Texture& texture);
+
+	ThreadPool* pool;
+	Timeline* timeline;
+	std::unique_ptr<TextureStreamer> streamer;
+	std::vector<std::shared_ptr<PendingTexture> > pending; // Being decoded, in request order.
+	ResourceTable<Mesh> meshes;
+	ResourceTable<Texture> textures;
+	ResourceTable<Program> programs;
+	int programBinaries;         // Whether the driver saves programs (programCache.hpp), -1 until known.
+	bool parallelCompile;
+	uint64_t driverHash;
+	unsigned int programBinaryLoads; // Programs that skipped compiling.
+};
+
+#endif
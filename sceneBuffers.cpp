@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "sceneBuffers.hpp"
+#include "glState.hpp"
+#include "resourceManager.hpp"
+#include "vertexFormat.hpp"
+
+ObjectData::ObjectData(const glm::mat4& model, float layer, int mesh) {
+	//glm is column major, the shader wants rows.
+	for (int row = 0; row < 3; row++) {
+		rows[row] = glm::vec4(model[0][row], model[1][row], model[2][row], model[3][row]);
+	}
+	params = glm::vec4(layer, (float)mesh, 0.0f, 0.0f);
+}
+
+SceneBuffers::SceneBuffers() : uniformAlignment(FRAME_RING_ALIGNMENT), objectTexture(0),
+	objectIndexBuffer(0), objectIndexCount(0), commandOffset(0), uploadedCommands(0) {
+	camera.view = camera.projection = camera.viewProjection = glm::mat4(1.0f);
+	camera.position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	camera.objectStart = glm::ivec4(0);
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	if (uniformAlignment <= 0 || (size_t)uniformAlignment > FRAME_RING_ALIGNMENT) uniformAlignment = FRAME_RING_ALIGNMENT;
+
+	glGenTextures(1, &objectTexture);
+	attachObjectTexture();
+
+	glGenBuffers(1, &objectIndexBuffer);
+
+	//Base instance is what tells the commands' objects apart, so both are needed.
+	canMultiDraw = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+	multiDraw = canMultiDraw;
+}
+
+void SceneBuffers::release() {
+	geometry.release();
+	ring.release();
+	if (objectIndexBuffer) glDeleteBuffers(1, &objectIndexBuffer);
+	if (objectTexture) glDeleteTextures(1, &objectTexture);
+	objectIndexBuffer = objectTexture = 0;
+	objectIndexCount = 0;
+}
+
+void SceneBuffers::attachObjectTexture() {
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if ((size_t)maxTexels < ring.bytes() / 16) {
+		printf("The object list (%u KB) is bigger than the GPU's texture buffers\n", (unsigned int)(ring.bytes() >> 10));
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, objectTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ring.id());
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+bool SceneBuffers::setMeshes(const std::vector<MeshHandle>& meshes) {
+	if (meshes.empty() || meshes.size() > (size_t)SCENE_MAX_MESHES) {
+		printf("The scene takes 1 to %d meshes, not %u\n", SCENE_MAX_MESHES, (unsigned int)meshes.size());
+		return false;
+	}
+	geometry.release();
+	meshDraws.clear();
+	uvTransforms.clear();
+
+	size_t vertices = 0, indices = 0;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		DrawCommand draw;
+		draw.count = (GLuint)meshes[i]->indexCount;
+		draw.instanceCount = 1;
+		draw.firstIndex = (GLuint)indices;
+		draw.baseVertex = (GLint)vertices;
+		draw.baseInstance = 0;
+		meshDraws.push_back(draw);
+		uvTransforms.push_back(meshes[i]->uvTransform);
+		vertices += meshes[i]->vertexCount;
+		indices += meshes[i]->indexCount;
+	}
+	geometry.vertexCount = vertices;
+	geometry.indexCount = indices;
+
+	//Copied from the meshes' buffers, GPU side. Indices stay relative to
+	//their own mesh, the draws' base vertex moves them.
+	GLint boundVertexArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &boundVertexArray);
+	glGenVertexArrays(1, &geometry.vertexArray);
+	glBindVertexArray(geometry.vertexArray);
+
+	glGenBuffers(1, &geometry.vertexBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, geometry.vertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertices * sizeof(PackedVertex), NULL, GL_STATIC_DRAW);
+	for (size_t i = 0; i < meshes.size(); i++) {
+		glBindBuffer(GL_COPY_READ_BUFFER, meshes[i]->vertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+			meshDraws[i].baseVertex * sizeof(PackedVertex), meshes[i]->vertexCount * sizeof(PackedVertex));
+	}
+
+	glGenBuffers(1, &geometry.elementBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, geometry.elementBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, indices * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+	for (size_t i = 0; i < meshes.size(); i++) {
+		glBindBuffer(GL_COPY_READ_BUFFER, meshes[i]->elementBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+			meshDraws[i].firstIndex * sizeof(unsigned int), meshes[i]->indexCount * sizeof(unsigned int));
+	}
+
+	geometry.setAttributes();
+
+	// 4th attribute : object index, one per instance
+	growObjectIndices(1);
+	glBindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+	glEnableVertexAttribArray(OBJECT_INDEX_ATTRIBUTE);
+	glVertexAttribIPointer(
+		OBJECT_INDEX_ATTRIBUTE,                 // attribute
+		1,                                      // size
+		GL_UNSIGNED_INT,                        // type
+		0,                                      // stride
+		(void*)0                                // array buffer offset
+	);
+	glVertexAttribDivisor(OBJECT_INDEX_ATTRIBUTE, 1);
+
+	glBindVertexArray((GLuint)boundVertexArray);
+	return true;
+}
+
+//Leaves objectIndexBuffer bound to GL_ARRAY_BUFFER.
+void SceneBuffers::growObjectIndices(size_t count) {
+	if (count <= objectIndexCount) return;
+	size_t capacity = std::max(count, std::max(objectIndexCount * 2, (size_t)1024));
+	std::vector<GLuint> indices(capacity);
+	for (size_t i = 0; i < capacity; i++) indices[i] = (GLuint)i;
+	glBindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+	objectIndexCount = capacity;
+}
+
+void SceneBuffers::setUniforms(Program& program, int objectUnit) const {
+	GLuint block = glGetUniformBlockIndex(program.id, "Camera");
+	if (block != GL_INVALID_INDEX) glUniformBlockBinding(program.id, block, CAMERA_BLOCK_BINDING);
+	glUseProgram(program.id);
+	glUniform1i(program.uniform("objects"), objectUnit);
+	if (!uvTransforms.empty()) {
+		glUniform4fv(program.uniform("uvTransforms"), (GLsizei)uvTransforms.size(), &uvTransforms[0][0]);
+	}
+}
+
+void SceneBuffers::setCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position) {
+	camera.view = view;
+	camera.projection = projection;
+	camera.viewProjection = projection * view;
+	camera.position = glm::vec4(position, 1.0f);
+}
+
+void SceneBuffers::upload(GLStateCache& state, int objectUnit) {
+	size_t objectBytes = objects.size() * sizeof(ObjectData);
+	size_t commandBytes = multiDraw ? queue.size() * sizeof(DrawCommand) : 0;
+	//With the worst case padding in front of each.
+	size_t frameBytes = objectBytes + sizeof(ObjectData) + sizeof(CameraBlock) + uniformAlignment + commandBytes + sizeof(DrawCommand);
+	if (ring.beginFrame(frameBytes)) {
+		//A new buffer, the texture and whatever the cache thinks is bound are stale.
+		attachObjectTexture();
+		state.invalidate();
+	}
+
+	//The objects go at a whole ObjectData into the ring, so the shader can
+	//count from the start of the texture.
+	size_t objectOffset = 0;
+	unsigned char* destination = ring.allocate(objectBytes, sizeof(ObjectData), objectOffset);
+	if (destination && objectBytes) memcpy(destination, &objects[0], objectBytes);
+	camera.objectStart = glm::ivec4((int)(objectOffset / sizeof(ObjectData)), 0, 0, 0);
+
+	size_t cameraOffset = 0;
+	destination = ring.allocate(sizeof(CameraBlock), uniformAlignment, cameraOffset);
+	if (destination) memcpy(destination, &camera, sizeof(CameraBlock));
+
+	uploadedCommands = 0;
+	if (commandBytes) {
+		destination = ring.allocate(commandBytes, sizeof(GLuint), commandOffset);
+		if (destination) {
+			memcpy(destination, &queue[0], commandBytes);
+			uploadedCommands = queue.size();
+		}
+	}
+	ring.flush();
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, ring.id(), cameraOffset, sizeof(CameraBlock));
+	if (objects.size() > objectIndexCount) {
+		state.bindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+		growObjectIndices(objects.size());
+	}
+	state.bindTexture(objectUnit, GL_TEXTURE_BUFFER, objectTexture);
+}
+
+void SceneBuffers::draw(GLStateCache& state, GLint firstObjectUniform, int mesh, size_t firstObject, size_t count) {
+	if (count == 0 || mesh < 0 || mesh >= (int)meshDraws.size()) return;
+	const DrawCommand& part = meshDraws[mesh];
+	state.bindVertexArray(geometry.vertexArray);
+	glUniform1i(firstObjectUniform, (GLint)firstObject);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, part.count, GL_UNSIGNED_INT,
+		(void*)(part.firstIndex * sizeof(unsigned int)), (GLsizei)count, part.baseVertex);
+}
+
+void SceneBuffers::queueDraw(int mesh, size_t firstObject, size_t count) {
+	if (count == 0 || mesh < 0 || mesh >= (int)meshDraws.size()) return;
+	DrawCommand command = meshDraws[mesh];
+	command.instanceCount = (GLuint)count;
+	command.baseInstance = (GLuint)firstObject;
+	queue.push_back(command);
+}
+
+unsigned int SceneBuffers::drawQueued(GLStateCache& state, GLint firstObjectUniform) {
+	if (queue.empty()) return 0;
+	unsigned int calls = 0;
+	state.bindVertexArray(geometry.vertexArray);
+	if (multiDraw && uploadedCommands == queue.size()) {
+		//Each command's base instance is its first object, the object index
+		//attribute starts there. The commands were written by upload().
+		state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.id());
+		glUniform1i(firstObjectUniform, 0);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset, (GLsizei)queue.size(), 0);
+		calls = 1;
+	} else {
+		for (size_t i = 0; i < queue.size(); i++) {
+			const DrawCommand& command = queue[i];
+			glUniform1i(firstObjectUniform, (GLint)command.baseInstance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+				(void*)(command.firstIndex * sizeof(unsigned int)), (GLsizei)command.instanceCount, command.baseVertex);
+			calls++;
+		}
+	}
+	queue.clear();
+	uploadedCommands = 0;
+	return calls;
+}
@@ -0,0 +1,150 @@
+#ifndef SCENEBUFFERS_HPP
+#define SCENEBUFFERS_HPP
+
+// What the vertex shader needs to place things, uploaded once a frame
+// instead of an MVP matrix worked out and set per draw:
+//
+//   - the camera, a std140 uniform block "Camera" on CAMERA_BLOCK_BINDING;
+//   - every body drawn this frame, an ObjectData each, in a texture buffer
+//     the shader reads as "objects".
+//
+// A draw then only says where its bodies start in the list. The object list
+// is a texture buffer, not a uniform block, so it isn't limited to 64 KB: the
+// meteor belt can have as many bodies as the GPU can draw.
+//
+// Both, and the draw commands, are written into a FrameRing (frameRing.hpp),
+// a part of its region each frame. The object list's texture looks at the
+// whole ring, the camera block says where this frame's objects start in it.
+//
+// The scene's meshes are copied into one vertex and one index buffer, so
+// every draw can use the same vertex array. The draws of a frame are queued
+// and, with multi draw indirect (GL 4.3 or ARB_multi_draw_indirect with base
+// instance), go out as a single glMultiDrawElementsIndirect from a
+// GL_DRAW_INDIRECT_BUFFER. The vertex array has one more attribute, the
+// object index, read from a buffer holding 0, 1, 2... once per instance:
+// base instance moves where that starts, so instance i of a command is
+// object baseInstance + i. Without it each draw is its own call, with the
+// firstObject uniform set instead.
+#include <stddef.h>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "frameRing.hpp"
+#include "resourceManager.hpp"
+
+class GLStateCache;
+
+const GLuint CAMERA_BLOCK_BINDING = 0;
+
+// The object index attribute, after the mesh's 0 to 2.
+const GLuint OBJECT_INDEX_ATTRIBUTE = 3;
+
+// Size of the shader's uvTransforms array, the most meshes setMeshes() takes.
+const int SCENE_MAX_MESHES = 8;
+
+// Laid out as the shader's Camera block, std140.
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 position;     // w is 1
+	glm::ivec4 objectStart; // x : this frame's first object in the object list
+};
+
+// One body : the top three rows of its model matrix (the bottom one is
+// always 0 0 0 1), its layer of the body texture array and the mesh it is
+// drawn with, for the mesh's UV transform. Four RGBA32F texels of the
+// texture buffer.
+struct ObjectData {
+	ObjectData() {}
+	ObjectData(const glm::mat4& model, float layer, int mesh);
+	glm::vec4 rows[3];
+	glm::vec4 params; // x : layer, y : mesh
+};
+
+// GL's DrawElementsIndirectCommand.
+struct DrawCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+class SceneBuffers {
+public:
+	// GL calls from here on, on the thread with the context.
+	SceneBuffers();
+	~SceneBuffers() { release(); }
+	void release();
+
+	// Copies the meshes into the scene's buffers. Their index in the list
+	// is what ObjectData and draw() take. Before setUniforms(), once.
+	bool setMeshes(const std::vector<MeshHandle>& meshes);
+
+	// Hooks program's Camera block, objects sampler (to objectUnit) and UV
+	// transforms up. Once per program, it's left in use.
+	void setUniforms(Program& program, int objectUnit) const;
+
+	void setCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position);
+
+	// Filled by the caller every frame, in the order the draws want them.
+	std::vector<ObjectData> objects;
+
+	// Writes the camera, the objects and the queued draws into the frame
+	// ring, once a frame after all three are set, and binds the object list
+	// to objectUnit.
+	void upload(GLStateCache& state, int objectUnit);
+
+	// After the frame's last draw, so its part of the ring is reused only
+	// once the GPU is done with it.
+	void endFrame() { ring.endFrame(); }
+
+	// The GL_TEXTURE_BUFFER texture, to bind it again after other code
+	// changed the texture bindings.
+	GLuint objectList() const { return objectTexture; }
+
+	// count objects from firstObject drawn with mesh, right away, with the
+	// program in use. firstObjectUniform is its location of firstObject.
+	void draw(GLStateCache& state, GLint firstObjectUniform, int mesh, size_t firstObject, size_t count);
+
+	// The same, but queued until drawQueued(), which sends them all with
+	// the program in use and clears the queue. Returns the draw calls it took.
+	// Queue before upload(), which writes the draw commands.
+	void queueDraw(int mesh, size_t firstObject, size_t count);
+	unsigned int drawQueued(GLStateCache& state, GLint firstObjectUniform);
+
+	bool multiDrawSupported() const { return canMultiDraw; }
+	// On by default where supported. Off draws the queue one call at a time.
+	void setMultiDraw(bool on) { multiDraw = on && canMultiDraw; }
+	bool multiDrawing() const { return multiDraw; }
+
+	void printStats() const { ring.printStats(); }
+
+private:
+	SceneBuffers(const SceneBuffers&);
+	SceneBuffers& operator=(const SceneBuffers&);
+
+	void growObjectIndices(size_t count);
+
+	// Points the object list's texture at the ring's buffer.
+	void attachObjectTexture();
+
+	FrameRing ring;
+	GLint uniformAlignment;
+	CameraBlock camera;
+	GLuint objectTexture;
+
+	Mesh geometry;                      // All the meshes, in one vertex array.
+	std::vector<DrawCommand> meshDraws; // Each mesh's part of it, one instance from object 0.
+	std::vector<glm::vec4> uvTransforms;
+	GLuint objectIndexBuffer;           // 0, 1, 2... for the object index attribute.
+	size_t objectIndexCount;
+
+	std::vector<DrawCommand> queue;
+	size_t commandOffset, uploadedCommands; // This frame's commands in the ring.
+	bool canMultiDraw, multiDraw;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <GL/glew.h>
+
+#include "shader.hpp"
+
+bool readShaderFile(const char* path, std::string& out) {
+	std::ifstream stream(path, std::ios::in);
+	if (!stream.is_open()) return false;
+	std::stringstream sstr;
+	sstr << stream.rdbuf();
+	out = sstr.str();
+	return true;
+}
+
+static bool parallelCompile = false;
+
+bool enableParallelShaderCompile() {
+	// Let the driver pick the number of threads
+	if (GLEW_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xffffffff);
+	else if (GLEW_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xffffffff);
+	parallelCompile = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+	return parallelCompile;
+}
+
+void submitProgram(const char* vertex_name, const std::string& VertexShaderCode,
+	const char* fragment_name, const std::string& FragmentShaderCode, ProgramBuild& build) {
+
+	build.vertexName = vertex_name;
+	build.fragmentName = fragment_name;
+
+	// Create the shaders
+	build.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	build.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+	// Compile Vertex Shader
+	printf("Compiling shader : %s\n", vertex_name);
+	char const* VertexSourcePointer = VertexShaderCode.c_str();
+	glShaderSource(build.vertexShader, 1, &VertexSourcePointer, NULL);
+	glCompileShader(build.vertexShader);
+
+	// Compile Fragment Shader
+	printf("Compiling shader : %s\n", fragment_name);
+	char const* FragmentSourcePointer = FragmentShaderCode.c_str();
+	glShaderSource(build.fragmentShader, 1, &FragmentSourcePointer, NULL);
+	glCompileShader(build.fragmentShader);
+
+	// Link the program. The compile status is only asked for in finishProgram(),
+	// asking now would wait for the compiler.
+	printf("Linking program\n");
+	build.program = glCreateProgram();
+	// Let the driver keep what glGetProgramBinary needs (programCache.hpp)
+	if (GLEW_ARB_get_program_binary) glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(build.program, build.vertexShader);
+	glAttachShader(build.program, build.fragmentShader);
+	glLinkProgram(build.program);
+}
+
+bool programBuildDone(const ProgramBuild& build) {
+	if (!build.vertexShader || !parallelCompile) return true;
+	GLint done = GL_FALSE;
+	glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+static void printShaderLog(GLuint ShaderID) {
+	int InfoLogLength;
+	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if (InfoLogLength > 0) {
+		std::vector<char> ShaderErrorMessage(InfoLogLength + 1);
+		glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		printf("%s\n", &ShaderErrorMessage[0]);
+	}
+}
+
+bool finishProgram(ProgramBuild& build) {
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
+	if (!build.vertexShader) {
+		glGetProgramiv(build.program, GL_LINK_STATUS, &Result);
+		return Result == GL_TRUE;
+	}
+
+	// Check the shaders
+	printShaderLog(build.vertexShader);
+	printShaderLog(build.fragmentShader);
+
+	// Check the program
+	glGetProgramiv(build.program, GL_LINK_STATUS, &Result);
+	glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if (InfoLogLength > 0) {
+		std::vector<char> ProgramErrorMessage(InfoLogLength + 1);
+		glGetProgramInfoLog(build.program, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+		printf("%s\n", &ProgramErrorMessage[0]);
+	}
+	if (Result != GL_TRUE) printf("Could not link %s + %s\n", build.vertexName.c_str(), build.fragmentName.c_str());
+
+	glDetachShader(build.program, build.vertexShader);
+	glDetachShader(build.program, build.fragmentShader);
+
+	glDeleteShader(build.vertexShader);
+	glDeleteShader(build.fragmentShader);
+	build.vertexShader = 0;
+	build.fragmentShader = 0;
+
+	return Result == GL_TRUE;
+}
+
+GLuint LoadShadersFromSource(const char* vertex_name, const std::string& VertexShaderCode,
+	const char* fragment_name, const std::string& FragmentShaderCode) {
+	ProgramBuild build;
+	submitProgram(vertex_name, VertexShaderCode, fragment_name, FragmentShaderCode, build);
+	finishProgram(build);
+	return build.program;
+}
+
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path) {
+
+	// Read the Vertex Shader code from the file
+	std::string VertexShaderCode;
+	if (!readShaderFile(vertex_file_path, VertexShaderCode)) {
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
+		getchar();
+		return 0;
+	}
+
+	// Read the Fragment Shader code from the file
+	std::string FragmentShaderCode;
+	readShaderFile(fragment_file_path, FragmentShaderCode);
+
+	return LoadShadersFromSource(vertex_file_path, VertexShaderCode, fragment_file_path, FragmentShaderCode);
+}
@@ -0,0 +1,46 @@
+#ifndef SHADER_HPP
+#define SHADER_HPP
+
+#include <string>
+#include <GL/glew.h>
+
+// Reads a whole shader file, false if it can't be opened.
+bool readShaderFile(const char* path, std::string& out);
+
+// A program on its way: the shaders are compiled and the program linked by
+// the driver while the caller goes on. With KHR_parallel_shader_compile
+// (or the ARB one) that happens on the driver's own threads, and
+// programBuildDone() says when it's over without waiting. Without it the
+// work happens at the latest in finishProgram(), same as before.
+struct ProgramBuild {
+	ProgramBuild() : program(0), vertexShader(0), fragmentShader(0) {}
+	GLuint program;
+	GLuint vertexShader, fragmentShader; // 0 once finished.
+	std::string vertexName, fragmentName;
+};
+
+// Lets the driver compile on as many threads as it likes, when it can.
+// Once, with the context current. False when it can't.
+bool enableParallelShaderCompile();
+
+// Hands both shaders and the link to the driver and returns without asking
+// how any of it went. The names are only used in log messages.
+void submitProgram(const char* vertex_name, const std::string& VertexShaderCode,
+	const char* fragment_name, const std::string& FragmentShaderCode, ProgramBuild& build);
+
+// True when finishProgram() wouldn't have to wait.
+bool programBuildDone(const ProgramBuild& build);
+
+// Waits for the link, prints the logs and deletes the shaders. False when
+// it didn't link; build.program is there either way.
+bool finishProgram(ProgramBuild& build);
+
+// Compiles and links a vertex + fragment program from source already in
+// memory, waiting for it. The names are only used in log messages.
+GLuint LoadShadersFromSource(const char* vertex_name, const std::string& VertexShaderCode,
+	const char* fragment_name, const std::string& FragmentShaderCode);
+
+// Reads both files and does the above. 0 if a file is missing.
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
+
+#endif
@@ -0,0 +1,157 @@
+#include <math.h>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "simulation.hpp"
+#include "gravity.hpp"
+
+//Speeds, per frame at SIM_REFERENCE_HZ.
+static const float ORBIT_SPEED = glm::radians(100.0f) / 100.0f;
+static const float SPIN_SPEED = glm::radians(100.0f) / 100.0f;
+static const float METEOR_APPROACH = 0.01f; //Fraction of the remaining distance the meteor covers per frame.
+
+static const float SUN_HIT_DISTANCE = 17.0f;
+static const float PLANET_HIT_DISTANCE = 7.0f;
+static const float METEOR_SCALE = 0.4f;
+
+//Radius of the planet's orbit, length of (20,-10,0).
+static const float PLANET_ORBIT_RADIUS = 22.3607f;
+
+Simulation::Simulation(const glm::vec3& cameraPosition) {
+	current.rot_angle = 0.0f;
+	current.spin_angle = 0.0f;
+	current.meteorPosition = cameraPosition;
+	current.flag = 0;
+	current.meteorFlag = 0;
+	current.meteorDraw = 1;
+	camera = cameraPosition;
+	steps = 0;
+}
+
+void Simulation::throwMeteor() {
+	current.flag = 1;
+}
+
+void Simulation::setCameraPosition(const glm::vec3& cameraPosition) {
+	camera = cameraPosition;
+}
+
+void Simulation::enableSwarm(ThreadPool& pool, size_t count) {
+	GravitySettings settings = defaultGravitySettings();
+	swarmSystem.reset(new NBodySystem(pool, settings));
+
+	//Pick the sun's mass so a body on the planet's orbit goes round as fast as the planet does.
+	float omega = ORBIT_SPEED * SIM_REFERENCE_HZ;
+	float sunMass = omega * omega * PLANET_ORBIT_RADIUS * PLANET_ORBIT_RADIUS * PLANET_ORBIT_RADIUS / settings.G;
+	seedDisk(swarmSystem->bodies, count + 1, sunMass, 28.0f, 45.0f, settings, 2024);
+}
+
+void Simulation::step(float dt) {
+	float frames = dt * SIM_REFERENCE_HZ; //How many of the old frames dt is worth.
+
+	if (current.meteorDraw == 1) {
+		current.rot_angle += ORBIT_SPEED * frames;
+		current.spin_angle += SPIN_SPEED * frames;
+	}
+
+	if (current.meteorFlag == 1) {
+		current.meteorPosition = camera;
+	}
+
+	if (current.flag == 1) {
+		current.meteorFlag = 0; //Meteor is travelling towards the sun.
+
+		//Close the same fraction of the distance to (0,0,0) as the per-frame lerp did.
+		float keep = powf(1.0f - METEOR_APPROACH, frames);
+		current.meteorPosition = current.meteorPosition * keep;
+
+		//Meteor reached the sun, give it back to the camera.
+		if (glm::length(current.meteorPosition - glm::vec3(::sunModel(current)[3])) <= SUN_HIT_DISTANCE) {
+			current.meteorFlag = 1;
+			current.meteorPosition = camera;
+			current.flag = 0;
+		}
+	}
+
+	//Check for collision with the planet.
+	if (glm::length(current.meteorPosition - glm::vec3(::planetModel(current)[3])) <= PLANET_HIT_DISTANCE) {
+		current.meteorDraw = 0;
+		current.flag = 0;
+	}
+
+	if (swarmSystem) {
+		swarmSystem->step(dt);
+	}
+
+	steps++;
+}
+
+glm::mat4 sunModel(const SimState&) {
+	return glm::mat4(1.0f);
+}
+
+glm::mat4 planetModel(const SimState& s) {
+	glm::vec3 tvec = glm::vec3(20.0f, -10.0f, 0.0f);//Distance from (0,0,0).
+	glm::vec3 axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 spinAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	glm::mat4 translate = glm::translate(glm::mat4(1.0f), tvec);
+	glm::mat4 rotate = glm::rotate(glm::mat4(1.0f), s.rot_angle, axis);
+	glm::mat4 spin = glm::rotate(glm::mat4(1.0f), s.spin_angle, spinAxis);
+
+	return rotate * translate * spin;
+}
+
+glm::mat4 meteorModel(const SimState& s) {
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), s.meteorPosition);
+	return glm::scale(model, glm::vec3(METEOR_SCALE));
+}
+
+SimState interpolate(const SimState& a, const SimState& b, float alpha) {
+	SimState s = b; //Flags always come from the newest state.
+	s.rot_angle = glm::mix(a.rot_angle, b.rot_angle, alpha);
+	s.spin_angle = glm::mix(a.spin_angle, b.spin_angle, alpha);
+
+	//Don't slide the meteor back from the sun to the camera, just jump there.
+	if (a.meteorFlag == b.meteorFlag) {
+		s.meteorPosition = glm::mix(a.meteorPosition, b.meteorPosition, alpha);
+	}
+	return s;
+}
+
+//Longest frame we try to catch up on. Anything longer (a breakpoint, the window
+//being dragged) is dropped instead of running hundreds of steps in one go.
+static const double MAX_FRAME_SECONDS = 0.25;
+
+FixedStepper::FixedStepper(Simulation& sim, float stepSeconds)
+	: sim(sim), previous(sim.state()), stepSeconds(stepSeconds), accumulator(0.0) {
+}
+
+int FixedStepper::advance(double frameSeconds) {
+	if (frameSeconds > MAX_FRAME_SECONDS) frameSeconds = MAX_FRAME_SECONDS;
+	if (frameSeconds < 0.0) frameSeconds = 0.0;
+	accumulator += frameSeconds;
+
+	int count = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (accumulator >= stepSeconds) {
+		previous = sim.state();
+		sim.step(stepSeconds);
+		accumulator -= stepSeconds;
+		count++;
+
+		//Steps that take longer than the time they simulate (a big meteor belt
+		//on a slow machine) can never catch up, every frame would only owe more.
+		//Then the rest is dropped and the game runs in slow motion instead. A
+		//slow frame alone isn't a reason, MAX_FRAME_SECONDS already bounds it.
+		if (accumulator >= stepSeconds) {
+			double spent = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (spent > count * (double)stepSeconds) {
+				accumulator = fmod(accumulator, (double)stepSeconds);
+				break;
+			}
+		}
+	}
+	return count;
+}
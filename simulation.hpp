@@ -0,0 +1,93 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+// Orbit, meteor and collision logic of the solar system, without any GLFW/GLEW
+// dependency so it can also be stepped on machines without a display.
+#include <stddef.h>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "gravity.hpp"
+
+class ThreadPool;
+
+// The old render loop advanced everything once per swapped frame, so all the
+// tuning constants below are "per frame at this rate".
+const float SIM_REFERENCE_HZ = 60.0f;
+
+// Length of one fixed simulation step used by the game.
+const float SIM_STEP_SECONDS = 1.0f / 120.0f;
+
+// Everything that changes while the simulation runs.
+struct SimState {
+	float rot_angle;           // Planet's angle around the sun.
+	float spin_angle;          // Planet's angle around itself.
+	glm::vec3 meteorPosition;
+	int flag;                  // 1 while the meteor is travelling towards the sun.
+	int meteorFlag;            // 1 while the meteor waits at the camera to be thrown again.
+	int meteorDraw;            // 0 once the meteor has hit the planet.
+};
+
+// Blend two consecutive states, alpha = 0 gives a, alpha = 1 gives b.
+SimState interpolate(const SimState& a, const SimState& b, float alpha);
+
+// Model matrices of the bodies for a given state.
+glm::mat4 sunModel(const SimState& s);
+glm::mat4 planetModel(const SimState& s);
+glm::mat4 meteorModel(const SimState& s);
+
+class Simulation {
+public:
+	Simulation(const glm::vec3& cameraPosition);
+
+	// Advance the simulation by dt seconds.
+	void step(float dt);
+
+	// Keyboard actions and camera movement coming from the window side.
+	void throwMeteor();
+	void setCameraPosition(const glm::vec3& cameraPosition);
+
+	// Add a belt of count meteors around the sun that move under real gravity,
+	// with forces computed on pool. Body 0 of the swarm is the sun itself.
+	void enableSwarm(ThreadPool& pool, size_t count);
+	const NBodySystem* swarm() const { return swarmSystem.get(); }
+
+	const SimState& state() const { return current; }
+	unsigned long long stepCount() const { return steps; }
+
+	glm::mat4 sunModel() const { return ::sunModel(current); }
+	glm::mat4 planetModel() const { return ::planetModel(current); }
+	glm::mat4 meteorModel() const { return ::meteorModel(current); }
+
+private:
+	SimState current;
+	glm::vec3 camera;
+	unsigned long long steps;
+	std::unique_ptr<NBodySystem> swarmSystem;
+};
+
+// Runs the simulation at a fixed rate no matter how fast frames are drawn.
+// Real time is accumulated and consumed in whole steps; whatever is left over
+// is used to interpolate between the last two states when rendering.
+class FixedStepper {
+public:
+	FixedStepper(Simulation& sim, float stepSeconds);
+
+	// Add frameSeconds of real time and run as many steps as fit.
+	// Returns how many steps ran.
+	int advance(double frameSeconds);
+
+	// Fraction of a step left in the accumulator, in [0,1).
+	float alpha() const { return (float)(accumulator / stepSeconds); }
+
+	// State to draw: between the previous and the current step.
+	SimState renderState() const { return interpolate(previous, sim.state(), alpha()); }
+
+private:
+	Simulation& sim;
+	SimState previous;
+	float stepSeconds;
+	double accumulator;
+};
+
+#endif
@@ -0,0 +1,84 @@
+// Render-less driver for the simulation. Steps it as fast as possible and
+// reports steps per second, so it can run on machines without a display.
+//
+// usage: simulationBench [steps] [dt] [swarm meteors]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <glm/glm.hpp>
+
+#include "simulation.hpp"
+#include "threadPool.hpp"
+
+int main(int argc, char* argv[]) {
+	long long steps = 10000000;
+	float dt = 1.0f / SIM_REFERENCE_HZ;
+	if (argc > 1) steps = atoll(argv[1]);
+	if (argc > 2) dt = (float)atof(argv[2]);
+	size_t swarm = 0;
+	if (argc > 3) swarm = (size_t)atoll(argv[3]);
+	ThreadPool pool;
+
+	glm::vec3 position = glm::vec3(50.0f, 50.0f, 0.0f); //Same starting camera as the game.
+	Simulation sim(position);
+	if (swarm > 0) sim.enableSwarm(pool, swarm);
+
+	int throws = 0;
+	int hits = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (long long i = 0; i < steps; i++) {
+		//Keep throwing the meteor whenever it is idle, like a player holding SPACE.
+		if (sim.state().flag == 0) {
+			sim.throwMeteor();
+			throws++;
+		}
+		sim.step(dt);
+
+		//Planet got hit, start over so every step does the same amount of work.
+		if (sim.state().meteorDraw == 0) {
+			sim = Simulation(position);
+			if (swarm > 0) sim.enableSwarm(pool, swarm);
+			hits++;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	printf("steps      : %lld (dt = %f s, %zu swarm meteors)\n", steps, dt, swarm);
+	printf("throws     : %d, planet hits : %d\n", throws, hits);
+	printf("time       : %.3f s\n", seconds);
+	printf("steps/sec  : %.0f\n", steps / seconds);
+	printf("final angle: %f\n", sim.state().rot_angle); //Keeps the loop from being optimised away.
+
+	//Same 10 seconds of play drawn at different frame rates should end up in
+	//the same place now that the stepper decouples the two. That includes
+	//frames slower than 15 fps, which take many steps each to catch up. The
+	//meteor is thrown at 9 s, a frame start at every rate, so it is still in
+	//flight at the end. 60 Hz is what the others are held against.
+	const double rates[] = { 60.0, 5.0, 10.0, 30.0, 144.0, 240.0 };
+	const double PLAY_SECONDS = 10.0, THROW_SECONDS = 9.0;
+	//Rounding may differ a little between rates, a whole step (0.009 rad of orbit) must not.
+	const float TOLERANCE = 1e-4f;
+	SimState reference;
+	int mismatches = 0;
+	for (double hz : rates) {
+		Simulation fixedSim(position);
+		FixedStepper stepper(fixedSim, SIM_STEP_SECONDS);
+		for (int frame = 0; frame < (int)(PLAY_SECONDS * hz + 0.5); frame++) {
+			if (frame == (int)(THROW_SECONDS * hz + 0.5)) fixedSim.throwMeteor();
+			stepper.advance(1.0 / hz);
+		}
+		SimState s = stepper.renderState();
+		if (hz == rates[0]) reference = s;
+		float difference = std::max(fabsf(s.rot_angle - reference.rot_angle), fabsf(s.spin_angle - reference.spin_angle));
+		difference = std::max(difference, glm::length(s.meteorPosition - reference.meteorPosition));
+		bool same = difference <= TOLERANCE && s.flag == reference.flag && s.meteorFlag == reference.meteorFlag &&
+			s.meteorDraw == reference.meteorDraw;
+		printf("%5.0f Hz frames: orbit angle %f, meteor at (%f, %f, %f)%s\n", hz, s.rot_angle,
+			s.meteorPosition.x, s.meteorPosition.y, s.meteorPosition.z, same ? "" : "  DIFFERENT FROM 60 Hz");
+		if (!same) mismatches++;
+	}
+	return mismatches ? 1 : 0;
+}
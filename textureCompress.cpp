@@ -0,0 +1,282 @@
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "textureCompress.hpp"
+#include "threadPool.hpp"
+
+// One 4x4 block as floats, edge blocks padded by repeating the last row and column.
+struct Block {
+	float p[16][4];
+};
+
+static void loadBlock(const unsigned char* rgba, int width, int height, int bx, int by, Block& block) {
+	for (int y = 0; y < 4; y++) {
+		int sy = std::min(by * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++) {
+			int sx = std::min(bx * 4 + x, width - 1);
+			const unsigned char* s = rgba + ((size_t)sy * width + sx) * 4;
+			for (int c = 0; c < 4; c++) block.p[y * 4 + x][c] = s[c];
+		}
+	}
+}
+
+//The line through the block's colors that they are most spread along: the mean
+//and the main axis of their covariance (power iteration). The endpoints go on it.
+static void principalAxis(const Block& block, int channels, float mean[4], float axis[4], float& lo, float& hi) {
+	for (int c = 0; c < 4; c++) mean[c] = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < channels; c++) mean[c] += block.p[i][c] / 16.0f;
+	}
+	float cov[4][4] = { { 0 } };
+	for (int i = 0; i < 16; i++) {
+		float d[4];
+		for (int c = 0; c < channels; c++) d[c] = block.p[i][c] - mean[c];
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) cov[a][b] += d[a] * d[b];
+		}
+	}
+	for (int c = 0; c < 4; c++) axis[c] = c < channels ? 1.0f : 0.0f;
+	for (int iteration = 0; iteration < 8; iteration++) {
+		float next[4] = { 0, 0, 0, 0 };
+		float length = 0.0f;
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) next[a] += cov[a][b] * axis[b];
+			length += next[a] * next[a];
+		}
+		//Flat block: any axis will do.
+		if (length < 1e-8f) break;
+		length = 1.0f / sqrtf(length);
+		for (int a = 0; a < channels; a++) axis[a] = next[a] * length;
+	}
+	lo = 1e30f;
+	hi = -1e30f;
+	for (int i = 0; i < 16; i++) {
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++) t += (block.p[i][c] - mean[c]) * axis[c];
+		lo = std::min(lo, t);
+		hi = std::max(hi, t);
+	}
+}
+
+static float clampByte(float v) {
+	return std::min(255.0f, std::max(0.0f, v));
+}
+
+// BC1 : two RGB565 endpoints and 2 bit indices into them and two colors in between.
+
+static uint16_t to565(const float c[3]) {
+	int r = (int)(clampByte(c[0]) * 31.0f / 255.0f + 0.5f);
+	int g = (int)(clampByte(c[1]) * 63.0f / 255.0f + 0.5f);
+	int b = (int)(clampByte(c[2]) * 31.0f / 255.0f + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void from565(uint16_t v, float c[3]) {
+	int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (float)((r << 3) | (r >> 2));
+	c[1] = (float)((g << 2) | (g >> 4));
+	c[2] = (float)((b << 3) | (b >> 2));
+}
+
+//Picks the nearest palette entry for every pixel, returns the squared error.
+static float bc1Indices(const Block& block, uint16_t c0, uint16_t c1, uint32_t& indices) {
+	float palette[4][3];
+	from565(c0, palette[0]);
+	from565(c1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+		palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+	}
+	indices = 0;
+	float total = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		float bestError = 1e30f;
+		for (int k = 0; k < 4; k++) {
+			float error = 0.0f;
+			for (int c = 0; c < 3; c++) {
+				float d = block.p[i][c] - palette[k][c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = k;
+			}
+		}
+		indices |= (uint32_t)best << (2 * i);
+		total += bestError;
+	}
+	return total;
+}
+
+//c0 > c1 selects the four color mode, c0 == c1 is a flat block.
+static float encodeBC1Endpoints(const Block& block, const float e0[3], const float e1[3], uint16_t& c0, uint16_t& c1, uint32_t& indices) {
+	c0 = to565(e0);
+	c1 = to565(e1);
+	if (c0 < c1) std::swap(c0, c1);
+	if (c0 == c1) {
+		float flat[3];
+		from565(c0, flat);
+		float error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 3; c++) error += (block.p[i][c] - flat[c]) * (block.p[i][c] - flat[c]);
+		}
+		indices = 0;
+		return error;
+	}
+	return bc1Indices(block, c0, c1, indices);
+}
+
+static void encodeBC1(const Block& block, unsigned char* out) {
+	float mean[4], axis[4], lo, hi;
+	principalAxis(block, 3, mean, axis, lo, hi);
+	float e0[3], e1[3];
+	for (int c = 0; c < 3; c++) {
+		e0[c] = mean[c] + axis[c] * hi;
+		e1[c] = mean[c] + axis[c] * lo;
+	}
+	uint16_t c0, c1;
+	uint32_t indices;
+	float error = encodeBC1Endpoints(block, e0, e1, c0, c1, indices);
+
+	//Once the indices are known, least squares gives endpoints that fit them better.
+	if (c0 != c1) {
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++) {
+			float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < 3; c++) {
+				ax[c] += a * block.p[i][c];
+				bx[c] += b * block.p[i][c];
+			}
+		}
+		float det = aa * bb - ab * ab;
+		if (fabsf(det) > 1e-6f) {
+			float r0[3], r1[3];
+			for (int c = 0; c < 3; c++) {
+				r0[c] = (ax[c] * bb - bx[c] * ab) / det;
+				r1[c] = (bx[c] * aa - ax[c] * ab) / det;
+			}
+			uint16_t d0, d1;
+			uint32_t refined;
+			float refinedError = encodeBC1Endpoints(block, r0, r1, d0, d1, refined);
+			if (refinedError < error) {
+				c0 = d0;
+				c1 = d1;
+				indices = refined;
+			}
+		}
+	}
+
+	out[0] = (unsigned char)(c0 & 0xff);
+	out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xff);
+	out[3] = (unsigned char)(c1 >> 8);
+	for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// BC7 mode 6 : one subset, RGBA endpoints of 7 bits plus a shared low bit per
+// endpoint, 4 bit indices.
+
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+//7 bits per channel and the p bit that gets closest to the wanted endpoint.
+static void quantizeBC7Endpoint(const float e[4], int q[4], int& pbit, int expanded[4]) {
+	float bestError = 1e30f;
+	for (int p = 0; p < 2; p++) {
+		int candidate[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++) {
+			candidate[c] = std::min(127, std::max(0, (int)floorf((clampByte(e[c]) - p) / 2.0f + 0.5f)));
+			float d = (float)((candidate[c] << 1) | p) - e[c];
+			error += d * d;
+		}
+		if (error < bestError) {
+			bestError = error;
+			pbit = p;
+			for (int c = 0; c < 4; c++) q[c] = candidate[c];
+		}
+	}
+	for (int c = 0; c < 4; c++) expanded[c] = (q[c] << 1) | pbit;
+}
+
+static void putBits(unsigned char* out, int& position, uint32_t value, int count) {
+	for (int i = 0; i < count; i++, position++) {
+		if ((value >> i) & 1) out[position >> 3] |= (unsigned char)(1 << (position & 7));
+	}
+}
+
+static void encodeBC7(const Block& block, unsigned char* out) {
+	float mean[4], axis[4], lo, hi;
+	principalAxis(block, 4, mean, axis, lo, hi);
+	float e0[4], e1[4];
+	for (int c = 0; c < 4; c++) {
+		e0[c] = mean[c] + axis[c] * lo;
+		e1[c] = mean[c] + axis[c] * hi;
+	}
+	int q0[4], q1[4], p0, p1, x0[4], x1[4];
+	quantizeBC7Endpoint(e0, q0, p0, x0);
+	quantizeBC7Endpoint(e1, q1, p1, x1);
+
+	int palette[16][4];
+	for (int k = 0; k < 16; k++) {
+		for (int c = 0; c < 4; c++) palette[k][c] = ((64 - bc7Weights[k]) * x0[c] + bc7Weights[k] * x1[c] + 32) >> 6;
+	}
+	int indices[16];
+	for (int i = 0; i < 16; i++) {
+		float bestError = 1e30f;
+		for (int k = 0; k < 16; k++) {
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				float d = block.p[i][c] - palette[k][c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				indices[i] = k;
+			}
+		}
+	}
+
+	//The first index is stored without its top bit, so it has to be below 8.
+	if (indices[0] >= 8) {
+		for (int c = 0; c < 4; c++) std::swap(q0[c], q1[c]);
+		std::swap(p0, p1);
+		for (int i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+	}
+
+	memset(out, 0, 16);
+	int position = 0;
+	putBits(out, position, 1 << 6, 7); //Mode 6.
+	for (int c = 0; c < 4; c++) {
+		putBits(out, position, q0[c], 7);
+		putBits(out, position, q1[c], 7);
+	}
+	putBits(out, position, p0, 1);
+	putBits(out, position, p1, 1);
+	putBits(out, position, indices[0], 3);
+	for (int i = 1; i < 16; i++) putBits(out, position, indices[i], 4);
+}
+
+void compressImage(TextureCodec codec, const unsigned char* rgba, int width, int height, unsigned char* out, ThreadPool* pool) {
+	int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+	size_t bytes = blockBytes(codec);
+	auto rows = [&](size_t begin, size_t end) {
+		Block block;
+		for (size_t by = begin; by < end; by++) {
+			for (int bx = 0; bx < blocksWide; bx++) {
+				loadBlock(rgba, width, height, bx, (int)by, block);
+				unsigned char* destination = out + (by * blocksWide + bx) * bytes;
+				if (codec == TEXTURE_BC1) encodeBC1(block, destination);
+				else encodeBC7(block, destination);
+			}
+		}
+	};
+	if (pool) pool->parallelFor(0, blocksHigh, 4, rows);
+	else rows(0, blocksHigh);
+}
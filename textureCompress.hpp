@@ -0,0 +1,18 @@
+#ifndef TEXTURECOMPRESS_HPP
+#define TEXTURECOMPRESS_HPP
+
+// Block compression for the texture cook. Offline only, the game never
+// compresses anything, it just uploads what the cook wrote.
+#include <stddef.h>
+
+#include "cookedTexture.hpp"
+
+class ThreadPool;
+
+// Compresses a tightly packed RGBA8 image into 4x4 blocks, left to right, top
+// to bottom. out must have room for compressedSize(codec, width, height).
+// BC1 ignores alpha; BC7 uses mode 6 (one RGBA subset, 16 shades per block).
+// Rows of blocks are spread over pool when given one.
+void compressImage(TextureCodec codec, const unsigned char* rgba, int width, int height, unsigned char* out, ThreadPool* pool = NULL);
+
+#endif
@@ -0,0 +1,159 @@
+// Cooks images into <name>.ctex files the game maps and uploads as they are:
+// the whole mip chain, block compressed. Run it again after changing an image,
+// the game ignores cooked files whose image has changed since.
+//
+// With -virtual, cuts them into the tiles of a virtual texture instead
+// (<name>.vtex, see tiledTexture.hpp), for images too big to load whole.
+//
+// usage: textureCook [-bc7] [-box] [-virtual] [image ...]
+//   (default: sun.jpg planet.jpg meteor.jpg, BC1, Kaiser filtered mips)
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "cookedTexture.hpp"
+#include "hash.hpp"
+#include "mappedFile.hpp"
+#include "mipChain.hpp"
+#include "textureCompress.hpp"
+#include "threadPool.hpp"
+#include "tiledTexture.hpp"
+
+//One level in memory at a time (plus the next one being filtered from it),
+//never the whole chain.
+static bool cookVirtual(const char* path, const MappedFile& source, MipFilter filter) {
+	auto start = std::chrono::steady_clock::now();
+	int width, height, channels;
+	if (!stbi_info_from_memory(source.data(), (int)source.size(), &width, &height, &channels)) {
+		printf("Failed to load texture %s : %s\n", path, stbi_failure_reason());
+		return false;
+	}
+	if (tiledLevelCount(width, height) == 0) {
+		printf("%s : %dx%d can't be a virtual texture, it needs power of two sides of at most %d\n",
+			path, width, height, TILE_SIZE * TILED_TEXTURE_MAX_TILES);
+		return false;
+	}
+	unsigned char* pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 0);
+	if (!pixels) {
+		printf("Failed to load texture %s : %s\n", path, stbi_failure_reason());
+		return false;
+	}
+
+	std::string tiledPath = tiledTexturePath(path);
+	TiledTextureWriter writer;
+	bool ok = writer.begin(tiledPath.c_str(), width, height, channels, hashBytes(source.data(), source.size()), source.size());
+	std::vector<unsigned char> level, next;
+	const unsigned char* current = pixels;
+	int w = width, h = height;
+	for (int i = 0; ok && i < writer.levelCount(); i++) {
+		ok = writer.writeLevel(i, current);
+		if (ok && i + 1 < writer.levelCount()) {
+			int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+			next.resize((size_t)nw * nh * channels);
+			halveLevel(current, w, h, channels, &next[0], filter);
+			level.swap(next);
+			current = &level[0];
+			w = nw;
+			h = nh;
+		}
+		if (current != pixels && pixels) {
+			stbi_image_free(pixels);
+			pixels = NULL;
+		}
+	}
+	stbi_image_free(pixels);
+	ok = writer.finish() && ok;
+	if (!ok) {
+		printf("Could not write %s\n", tiledPath.c_str());
+		return false;
+	}
+
+	MappedFile tiled;
+	size_t tiledBytes = tiled.open(tiledPath.c_str()) ? tiled.size() : 0;
+	size_t rawBytes = (size_t)width * height * channels * 4 / 3;
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%s : %dx%d, %d channels -> %s, %d levels of %dx%d tiles, %.1f MB on disk (whole mip chain %.1f MB), %.0f ms\n",
+		path, width, height, channels, tiledPath.c_str(), writer.levelCount(), TILE_SIZE, TILE_SIZE,
+		tiledBytes / (1024.0 * 1024.0), rawBytes / (1024.0 * 1024.0), ms);
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	TextureCodec codec = TEXTURE_BC1;
+	MipFilter filter = MIP_KAISER;
+	bool virtualTexture = false;
+	std::vector<const char*> paths;
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "-bc7") == 0) codec = TEXTURE_BC7;
+		else if (strcmp(argv[a], "-box") == 0) filter = MIP_BOX;
+		else if (strcmp(argv[a], "-virtual") == 0) virtualTexture = true;
+		else paths.push_back(argv[a]);
+	}
+	if (paths.empty()) {
+		paths.push_back("sun.jpg");
+		paths.push_back("planet.jpg");
+		paths.push_back("meteor.jpg");
+	}
+
+	ThreadPool pool;
+	int failures = 0;
+	for (size_t p = 0; p < paths.size(); p++) {
+		auto start = std::chrono::steady_clock::now();
+		MappedFile source;
+		if (!source.open(paths[p]) || source.size() == 0) {
+			printf("Impossible to open %s\n", paths[p]);
+			failures++;
+			continue;
+		}
+		if (virtualTexture) {
+			if (!cookVirtual(paths[p], source, filter)) failures++;
+			continue;
+		}
+		int width, height, channels;
+		unsigned char* pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 4);
+		if (!pixels) {
+			printf("Failed to load texture %s : %s\n", paths[p], stbi_failure_reason());
+			failures++;
+			continue;
+		}
+
+		//RGBA so BC7 gets alpha; BC1 ignores it.
+		std::vector<unsigned char> chain(mipChainBytes(width, height, 4));
+		memcpy(&chain[0], pixels, (size_t)width * height * 4);
+		stbi_image_free(pixels);
+		buildMipChain(&chain[0], width, height, 4, filter);
+
+		std::vector<std::vector<unsigned char> > levels;
+		const unsigned char* level = &chain[0];
+		for (int i = 0, count = mipLevelCount(width, height); i < count; i++) {
+			int w = std::max(1, width >> i), h = std::max(1, height >> i);
+			levels.push_back(std::vector<unsigned char>(compressedSize(codec, w, h)));
+			compressImage(codec, level, w, h, &levels.back()[0], &pool);
+			level += (size_t)w * h * 4;
+		}
+
+		std::string cookedPath = cookedTexturePath(paths[p]);
+		if (!writeCookedTexture(cookedPath.c_str(), codec, width, height, levels,
+			hashBytes(source.data(), source.size()), source.size())) {
+			printf("Could not write %s\n", cookedPath.c_str());
+			failures++;
+			continue;
+		}
+
+		size_t cookedBytes = 0;
+		for (size_t i = 0; i < levels.size(); i++) cookedBytes += levels[i].size();
+		//What the game used to keep in VRAM : the decoded pixels plus a third for the mips.
+		size_t rawBytes = (size_t)width * height * channels * 4 / 3;
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		printf("%s : %dx%d, %d channels -> %s, %s, %u %s filtered levels, %.1f KB (uncompressed with mips %.1f KB, %.1fx smaller), %.0f ms\n",
+			paths[p], width, height, channels, cookedPath.c_str(), codecName(codec), (unsigned int)levels.size(), mipFilterName(filter),
+			cookedBytes / 1024.0, rawBytes / 1024.0, (double)rawBytes / cookedBytes, ms);
+	}
+	return failures ? 1 : 0;
+}
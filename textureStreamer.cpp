@@ -0,0 +1,133 @@
+#include <string.h>
+#include <GL/glew.h>
+
+#include "textureStreamer.hpp"
+#include "mipChain.hpp"
+#include "glBuffer.hpp"
+
+// Offsets stay aligned to this, whatever the pixel size.
+static const size_t REGION_ALIGNMENT = 64;
+
+//Mapped once for good where it can be, so loader threads can write into it.
+TextureStreamer::TextureStreamer(size_t bytes) : buffer(0), mapped(NULL), size(bytes), head(0) {
+	buffer = createPersistentBuffer(GL_PIXEL_UNPACK_BUFFER, size, &mapped);
+}
+
+void TextureStreamer::release() {
+	for (size_t i = 0; i < regions.size(); i++) {
+		if (regions[i].fence) glDeleteSync(regions[i].fence);
+	}
+	regions.clear();
+	if (mapped) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		mapped = NULL;
+	}
+	if (buffer) glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	head = 0;
+}
+
+void TextureStreamer::retire() {
+	while (!regions.empty() && regions.front().done) {
+		Region& front = regions.front();
+		if (front.fence) {
+			GLenum status = glClientWaitSync(front.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+			glDeleteSync(front.fence);
+		}
+		regions.pop_front();
+	}
+}
+
+bool TextureStreamer::reserve(size_t bytes, size_t& offset) {
+	if (!buffer) return false;
+	retire();
+	bytes = (bytes + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+	if (bytes > size) return false;
+	if (regions.empty()) head = 0;
+
+	//Live regions run from tail up to head. Once head has wrapped past the end
+	//it sits below tail (or on it, when the ring is completely full).
+	size_t tail = regions.empty() ? 0 : regions.front().offset;
+	bool wrapped = !regions.empty() && head <= tail;
+	size_t start;
+	if (!wrapped && size - head >= bytes) start = head;
+	else if (!wrapped && tail >= bytes) start = 0;
+	else if (wrapped && tail - head >= bytes) start = head;
+	else return false;
+
+	Region region;
+	region.offset = start;
+	region.bytes = bytes;
+	region.done = false;
+	region.fence = 0;
+	regions.push_back(region);
+	head = start + bytes;
+	offset = start;
+	return true;
+}
+
+void TextureStreamer::upload(GLuint texture, size_t offset, int width, int height, GLenum format, const unsigned char* pixels, int layer) {
+	int channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+	int levels = mipLevelCount(width, height);
+	size_t bytes = mipChainBytes(width, height, channels);
+
+	// Storage for every level first, while no unpack buffer is bound (NULL would be an offset into it).
+	glBindTexture(layer >= 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int level = 0, w = width, h = height; layer < 0 && level < levels; level++) {
+		glTexImage2D(GL_TEXTURE_2D, level, format, w, h, 0, format, GL_UNSIGNED_BYTE, NULL);
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	if (pixels && mapped) {
+		memcpy(mapped + offset, pixels, bytes);
+	}
+	else if (pixels) {
+		//Unsynchronized is fine, the fences already keep us off ranges the GPU still reads.
+		void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (destination) {
+			memcpy(destination, pixels, bytes);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+	}
+	// The "pointer" is an offset into the bound unpack buffer.
+	size_t levelOffset = offset;
+	for (int level = 0, w = width, h = height; level < levels; level++) {
+		if (layer >= 0) glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, format, GL_UNSIGNED_BYTE, (const void*)levelOffset);
+		else glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, format, GL_UNSIGNED_BYTE, (const void*)levelOffset);
+		levelOffset += (size_t)w * h * channels;
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	for (size_t i = 0; i < regions.size(); i++) {
+		if (regions[i].offset == offset && !regions[i].done) {
+			regions[i].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			regions[i].done = true;
+			break;
+		}
+	}
+}
+
+void TextureStreamer::cancel(size_t offset) {
+	for (size_t i = 0; i < regions.size(); i++) {
+		if (regions[i].offset == offset && !regions[i].done) {
+			regions[i].done = true;
+			break;
+		}
+	}
+	retire();
+}
+
+size_t TextureStreamer::bytesInFlight() const {
+	size_t bytes = 0;
+	for (size_t i = 0; i < regions.size(); i++) bytes += regions[i].bytes;
+	return bytes;
+}
@@ -0,0 +1,69 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+// Texture uploads through a ring of pixel buffer memory. Pixels are copied
+// into one GL_PIXEL_UNPACK_BUFFER and glTexSubImage2D reads them from there,
+// so the driver copies on its own time instead of stalling the call, and the
+// CPU copy can be freed straight away. Each upload gets a fence, the space is
+// reused once the GPU has passed it.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistently, and
+// writePointer() can be filled from any thread (a loader thread decoding
+// straight into it). Without it each upload maps its range for the copy.
+#include <stddef.h>
+#include <deque>
+#include <GL/glew.h>
+
+// Enough for a handful of 1024x1024 RGB textures in flight.
+const size_t TEXTURE_STREAM_BYTES = 32 << 20;
+
+class TextureStreamer {
+public:
+	// GL calls from here on, on the thread with the context.
+	explicit TextureStreamer(size_t bytes = TEXTURE_STREAM_BYTES);
+	~TextureStreamer() { release(); }
+	void release();
+
+	bool persistent() const { return mapped != NULL; }
+	size_t capacity() const { return size; }
+
+	// Claims bytes of the ring. False if they don't fit right now (retry next
+	// frame) or ever (bytes > capacity(), upload from client memory instead).
+	bool reserve(size_t bytes, size_t& offset);
+
+	// Where to put the pixels of a reservation when persistent(), else NULL.
+	unsigned char* writePointer(size_t offset) const { return mapped ? mapped + offset : NULL; }
+
+	// Gives texture the reserved mip chain (all levels tightly packed, see
+	// mipChain.hpp), copying it in first when pixels isn't NULL. With a layer,
+	// texture is a GL_TEXTURE_2D_ARRAY that already has its storage and only
+	// that layer is filled in. The reservation is released once the GPU is
+	// done with it.
+	void upload(GLuint texture, size_t offset, int width, int height, GLenum format, const unsigned char* pixels, int layer = -1);
+
+	// Unused reservation (decoding failed), freed without a GL upload.
+	void cancel(size_t offset);
+
+	size_t bytesInFlight() const;
+
+private:
+	TextureStreamer(const TextureStreamer&);
+	TextureStreamer& operator=(const TextureStreamer&);
+
+	struct Region {
+		size_t offset, bytes;
+		bool done;   // Uploaded or cancelled.
+		GLsync fence;
+	};
+
+	// Frees regions from the front of the ring whose fences have signalled.
+	void retire();
+
+	GLuint buffer;
+	unsigned char* mapped;
+	size_t size;
+	size_t head; // Next free byte. Regions run from regions.front() to head, wrapping.
+	std::deque<Region> regions;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include <atomic>
+#include <memory>
+
+#include "threadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned threads) : stopping(false) {
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	for (unsigned i = 0; i < threads; i++) {
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+void ThreadPool::workerLoop() {
+	while (1) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+			if (jobs.empty()) return; //Only happens when stopping.
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> job) {
+	auto task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+	std::future<void> done = task->get_future();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back([task] { (*task)(); });
+	}
+	wake.notify_one();
+	return done;
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+	if (end <= begin) return;
+	if (grain == 0) grain = 1;
+	size_t chunks = (end - begin + grain - 1) / grain;
+	if (chunks == 1) {
+		fn(begin, end);
+		return;
+	}
+
+	//Chunks are handed out through a counter, so faster threads simply take
+	//more of them. The helpers sit in the same queue as everything else (tile
+	//reads, decodes), so we wait for the chunks to be done rather than for the
+	//helpers: one that only starts after the work is gone just returns. The
+	//state is shared for those late ones, fn is only called while we wait.
+	struct Work {
+		std::atomic<size_t> next, done;
+		std::mutex lock;
+		std::condition_variable finished;
+	};
+	auto work = std::make_shared<Work>();
+	work->next = 0;
+	work->done = 0;
+	const std::function<void(size_t, size_t)>* body = &fn;
+	auto run = [work, body, begin, end, grain, chunks]() {
+		size_t c;
+		while ((c = work->next.fetch_add(1)) < chunks) {
+			size_t b = begin + c * grain;
+			size_t e = b + grain < end ? b + grain : end;
+			(*body)(b, e);
+			if (work->done.fetch_add(1) + 1 == chunks) {
+				std::lock_guard<std::mutex> guard(work->lock);
+				work->finished.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = chunks - 1 < workers.size() ? chunks - 1 : workers.size();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t i = 0; i < helpers; i++) jobs.push_back(run);
+	}
+	if (helpers == 1) wake.notify_one();
+	else wake.notify_all();
+	run();
+
+	std::unique_lock<std::mutex> guard(work->lock);
+	work->finished.wait(guard, [&work, chunks] { return work->done.load() == chunks; });
+}
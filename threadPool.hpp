@@ -0,0 +1,43 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <stddef.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+// Fixed set of worker threads fed from one queue. Shared by everything that
+// wants to run work in parallel (gravity, loaders) so we don't end up with a
+// pool per subsystem fighting over the cores.
+class ThreadPool {
+public:
+	// threads = 0 uses one worker per hardware thread.
+	explicit ThreadPool(unsigned threads = 0);
+	~ThreadPool();
+
+	unsigned size() const { return (unsigned)workers.size(); }
+
+	// Queue a job, the future becomes ready when it has run.
+	std::future<void> submit(std::function<void()> job);
+
+	// Call fn(chunkBegin, chunkEnd) over [begin,end) in chunks of about grain
+	// items, on the workers and the calling thread. Returns when all chunks are
+	// done, without waiting for helpers still queued behind other jobs.
+	// Must not be called from inside a pool job.
+	void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex lock;
+	std::condition_variable wake;
+	bool stopping;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <algorithm>
+
+#include "tiledTexture.hpp"
+
+//Tiles start on a page boundary, so touching one maps no more than it needs.
+static const uint64_t DATA_ALIGNMENT = 4096;
+
+static bool isPowerOfTwo(int v) {
+	return v > 0 && (v & (v - 1)) == 0;
+}
+
+static int wrap(int v, int size) {
+	return ((v % size) + size) % size;
+}
+
+std::string tiledTexturePath(const char* imagePath) {
+	return std::string(imagePath) + ".vtex";
+}
+
+int tiledLevelCount(int width, int height) {
+	if (!isPowerOfTwo(width) || !isPowerOfTwo(height)) return 0;
+	if (width > TILE_SIZE * TILED_TEXTURE_MAX_TILES || height > TILE_SIZE * TILED_TEXTURE_MAX_TILES) return 0;
+	int levels = 1;
+	while (width > TILE_SIZE || height > TILE_SIZE) {
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		levels++;
+	}
+	return levels;
+}
+
+int TiledTexture::tilesWide(int level) const {
+	return std::max(1, (int)((header.width + TILE_SIZE - 1) / TILE_SIZE) >> level);
+}
+
+int TiledTexture::tilesHigh(int level) const {
+	return std::max(1, (int)((header.height + TILE_SIZE - 1) / TILE_SIZE) >> level);
+}
+
+bool openTiledTexture(const char* tiledPath, uint64_t sourceHash, uint64_t sourceSize, TiledTexture& out) {
+	out.firstTile.clear();
+	if (!out.file.open(tiledPath)) return false;
+
+	const MappedFile& file = out.file;
+	TiledTextureHeader& h = out.header;
+	bool ok = file.size() >= sizeof(h);
+	if (ok) {
+		memcpy(&h, file.data(), sizeof(h));
+		ok = memcmp(h.magic, "SSVT", 4) == 0 && h.version == TILED_TEXTURE_VERSION &&
+			(sourceSize == 0 || (h.sourceHash == sourceHash && h.sourceSize == sourceSize)) &&
+			h.channels >= 1 && h.channels <= 4 && h.tileSize == TILE_SIZE && h.tileBorder == TILE_BORDER &&
+			h.levelCount > 0 && (int)h.levelCount == tiledLevelCount((int)h.width, (int)h.height) &&
+			h.dataOffset >= sizeof(h) && h.dataOffset % DATA_ALIGNMENT == 0;
+	}
+
+	//Every tile of every level must be in the file.
+	size_t tiles = 0;
+	for (uint32_t level = 0; ok && level < h.levelCount; level++) {
+		out.firstTile.push_back(tiles);
+		tiles += (size_t)out.tilesWide(level) * out.tilesHigh(level);
+	}
+	out.firstTile.push_back(tiles);
+	ok = ok && h.dataOffset + tiles * out.tilePageBytes() <= file.size();
+	if (!ok) {
+		out.firstTile.clear();
+		out.file.close();
+	}
+	return ok;
+}
+
+TiledTextureWriter::TiledTextureWriter() : file(NULL), levelsWritten(0), ok(false) {
+	memset(&header, 0, sizeof(header));
+}
+
+TiledTextureWriter::~TiledTextureWriter() {
+	//Never finished: drop the half written file.
+	if (file) {
+		fclose(file);
+		remove(temp.c_str());
+	}
+}
+
+bool TiledTextureWriter::begin(const char* tiledPath, int width, int height, int channels, uint64_t sourceHash, uint64_t sourceSize) {
+	int levels = tiledLevelCount(width, height);
+	if (levels == 0 || channels < 1 || channels > 4 || file) return false;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SSVT", 4);
+	header.version = TILED_TEXTURE_VERSION;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.width = width;
+	header.height = height;
+	header.channels = channels;
+	header.tileSize = TILE_SIZE;
+	header.tileBorder = TILE_BORDER;
+	header.levelCount = levels;
+	header.dataOffset = (sizeof(header) + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+	//Same as the mesh cache: temporary name, then rename.
+	path = tiledPath;
+	temp = path + ".tmp";
+	levelsWritten = 0;
+	file = fopen(temp.c_str(), "wb");
+	if (file == NULL) return false;
+	static const unsigned char zeros[DATA_ALIGNMENT] = { 0 };
+	ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(zeros, 1, (size_t)(header.dataOffset - sizeof(header)), file) == header.dataOffset - sizeof(header);
+	return ok;
+}
+
+bool TiledTextureWriter::writeLevel(int level, const unsigned char* pixels) {
+	if (!file || !ok || level != levelsWritten || level >= (int)header.levelCount) return false;
+	int width = std::max(1, (int)header.width >> level), height = std::max(1, (int)header.height >> level);
+	int channels = (int)header.channels;
+	int tilesWide = std::max(1, (int)((header.width + TILE_SIZE - 1) / TILE_SIZE) >> level);
+	int tilesHigh = std::max(1, (int)((header.height + TILE_SIZE - 1) / TILE_SIZE) >> level);
+
+	//One tile with its border at a time. Past the image's edges it wraps around,
+	//like GL_REPEAT: planet maps go on across the seam.
+	std::vector<unsigned char> page((size_t)TILE_PAGE_SIZE * TILE_PAGE_SIZE * channels);
+	for (int ty = 0; ok && ty < tilesHigh; ty++) {
+		for (int tx = 0; ok && tx < tilesWide; tx++) {
+			unsigned char* out = &page[0];
+			for (int y = 0; y < TILE_PAGE_SIZE; y++) {
+				int sy = wrap(ty * TILE_SIZE + y - TILE_BORDER, height);
+				const unsigned char* row = pixels + (size_t)sy * width * channels;
+				for (int x = 0; x < TILE_PAGE_SIZE; x++, out += channels) {
+					int sx = wrap(tx * TILE_SIZE + x - TILE_BORDER, width);
+					memcpy(out, row + (size_t)sx * channels, channels);
+				}
+			}
+			ok = fwrite(&page[0], 1, page.size(), file) == page.size();
+		}
+	}
+	levelsWritten++;
+	return ok;
+}
+
+bool TiledTextureWriter::finish() {
+	if (!file) return false;
+	ok = ok && levelsWritten == (int)header.levelCount;
+	ok = fclose(file) == 0 && ok;
+	file = NULL;
+	if (!ok) {
+		remove(temp.c_str());
+		return false;
+	}
+	remove(path.c_str());
+	return rename(temp.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,105 @@
+#ifndef TILEDTEXTURE_HPP
+#define TILEDTEXTURE_HPP
+
+// Images too big to load whole (16K, 32K planet maps), cooked offline
+// (textureCook -virtual) into square tiles per mip level and written next to
+// the image as <name>.jpg.vtex. The game maps the file and reads only the
+// tiles it sees, see virtualTexture.hpp.
+//
+// Every tile holds TILE_SIZE x TILE_SIZE texels of its level plus a border of
+// TILE_BORDER texels copied from its neighbours (wrapping at the image edges), so
+// a tile sampled with bilinear filtering inside the page cache blends into
+// the right texels, not into whatever page sits next to it. Tiles are stored
+// uncompressed, 8 bits per channel, so any GL can take them.
+//
+// Levels go down until one tile holds the whole level. Width and height must
+// be powers of two: level n then has exactly (level 0 tiles) >> n tiles each
+// way, the same as the mips of the indirection table.
+//
+// File layout (little endian):
+//   TiledTextureHeader
+//   tiles from dataOffset on, level 0 first, rows top to bottom, each one
+//   tilePageBytes() long
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "mappedFile.hpp"
+
+const uint32_t TILED_TEXTURE_VERSION = 1;
+
+const int TILE_SIZE = 128;
+const int TILE_BORDER = 4;
+const int TILE_PAGE_SIZE = TILE_SIZE + 2 * TILE_BORDER;
+
+// Tile coordinates go through 8 bit channels on the GPU.
+const int TILED_TEXTURE_MAX_TILES = 256;
+
+struct TiledTextureHeader {
+	char magic[4];       // "SSVT"
+	uint32_t version;
+	uint64_t sourceHash; // hashBytes of the image file
+	uint64_t sourceSize;
+	uint32_t width;
+	uint32_t height;
+	uint32_t channels;
+	uint32_t tileSize;
+	uint32_t tileBorder;
+	uint32_t levelCount;
+	uint64_t dataOffset;
+};
+
+std::string tiledTexturePath(const char* imagePath);
+
+// Tile levels of a width x height image, 0 if it can't be tiled (not powers
+// of two, or more than TILED_TEXTURE_MAX_TILES tiles across at level 0).
+int tiledLevelCount(int width, int height);
+
+// A mapped, checked .vtex file.
+struct TiledTexture {
+	TiledTextureHeader header;
+	std::vector<size_t> firstTile; // Index of each level's first tile.
+	MappedFile file;
+
+	int levelCount() const { return (int)header.levelCount; }
+	int tilesWide(int level) const;
+	int tilesHigh(int level) const;
+	size_t tileCount() const { return firstTile.empty() ? 0 : firstTile.back(); }
+	size_t tileIndex(int level, int x, int y) const { return firstTile[level] + (size_t)y * tilesWide(level) + x; }
+	size_t tilePageBytes() const { return (size_t)TILE_PAGE_SIZE * TILE_PAGE_SIZE * header.channels; }
+	const unsigned char* tile(size_t index) const { return file.data() + header.dataOffset + index * tilePageBytes(); }
+};
+
+// False when the file is missing, damaged or from another format version.
+// The image itself may be left out of a build (it's the big thing the tiles
+// stand in for): sourceSize 0 skips the check that the tiles were cooked from it.
+bool openTiledTexture(const char* tiledPath, uint64_t sourceHash, uint64_t sourceSize, TiledTexture& out);
+
+// Writes the tiles level by level, so only the level being cut has to be in
+// memory. Goes to a temporary file, renamed into place by finish().
+class TiledTextureWriter {
+public:
+	TiledTextureWriter();
+	~TiledTextureWriter();
+
+	bool begin(const char* tiledPath, int width, int height, int channels, uint64_t sourceHash, uint64_t sourceSize);
+	// Levels in order, from 0. pixels is the whole level, tightly packed.
+	bool writeLevel(int level, const unsigned char* pixels);
+	bool finish();
+
+	int levelCount() const { return (int)header.levelCount; }
+
+private:
+	TiledTextureWriter(const TiledTextureWriter&);
+	TiledTextureWriter& operator=(const TiledTextureWriter&);
+
+	TiledTextureHeader header;
+	std::string path, temp;
+	FILE* file;
+	int levelsWritten;
+	bool ok;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "timeline.hpp"
+
+Timeline::Timeline() : zero(std::chrono::steady_clock::now()) {
+}
+
+double Timeline::now() const {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - zero).count();
+}
+
+void Timeline::add(const std::string& label, double startMs, double endMs) {
+	std::lock_guard<std::mutex> guard(lock);
+	std::thread::id id = std::this_thread::get_id();
+	unsigned int thread = (unsigned int)(std::find(threads.begin(), threads.end(), id) - threads.begin());
+	if (thread == threads.size()) threads.push_back(id);
+
+	Phase phase;
+	phase.label = label;
+	phase.thread = thread;
+	phase.start = startMs;
+	phase.end = endMs;
+	phases.push_back(phase);
+}
+
+void Timeline::print(const char* title) const {
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<Phase> sorted = phases;
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Phase& a, const Phase& b) { return a.start < b.start; });
+
+	double total = 0.0;
+	for (size_t i = 0; i < sorted.size(); i++) total = std::max(total, sorted[i].end);
+	const int columns = 50;
+
+	printf("%s, %.1f ms (thread 0 has the GL context)\n", title, total);
+	printf("   start     end   thread  phase\n");
+	for (size_t i = 0; i < sorted.size(); i++) {
+		const Phase& p = sorted[i];
+		char bar[columns + 1];
+		int from = total > 0.0 ? (int)(p.start / total * columns) : 0;
+		int to = total > 0.0 ? (int)(p.end / total * columns + 0.999) : 0;
+		if (to <= from) to = from + 1;
+		for (int c = 0; c < columns; c++) bar[c] = c >= from && c < to ? '#' : '.';
+		bar[columns] = '\0';
+		printf("%8.1f %7.1f   %6u  %-32s %s\n", p.start, p.end, p.thread, p.label.c_str(), bar);
+	}
+}
+
+Timeline::Scope::Scope(Timeline* timeline, const std::string& label) : timeline(timeline), label(label), start(0.0) {
+	if (timeline) start = timeline->now();
+}
+
+Timeline::Scope::~Scope() {
+	if (timeline) timeline->add(label, start, timeline->now());
+}
@@ -0,0 +1,49 @@
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+// Records what ran when, and on which thread, so startup can be printed as a
+// timeline: one row per phase with a bar showing where it sits. Any thread
+// may add to it.
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <thread>
+
+class Timeline {
+public:
+	Timeline(); // Time zero is now.
+
+	// Milliseconds since time zero.
+	double now() const;
+
+	// A phase that ran on the calling thread.
+	void add(const std::string& label, double startMs, double endMs);
+
+	void print(const char* title) const;
+
+	// Adds the phase from construction to destruction. timeline may be NULL.
+	class Scope {
+	public:
+		Scope(Timeline* timeline, const std::string& label);
+		~Scope();
+	private:
+		Timeline* timeline;
+		std::string label;
+		double start;
+	};
+
+private:
+	struct Phase {
+		std::string label;
+		unsigned int thread; // 0 is whoever added the first phase, usually main.
+		double start, end;
+	};
+
+	std::chrono::steady_clock::time_point zero;
+	mutable std::mutex lock;
+	std::vector<Phase> phases;
+	std::vector<std::thread::id> threads;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glm/glm.hpp>
+
+#include "vertexFormat.hpp"
+
+uint16_t floatToHalf(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff) {
+		return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0)); //Inf or NaN.
+	}
+	if (exponent >= 31) {
+		return (uint16_t)(sign | 0x7c00); //Too big, becomes infinity.
+	}
+	if (exponent <= 0) {
+		//Denormal or zero in half precision.
+		if (exponent < -10) return (uint16_t)sign;
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) half++;
+		return (uint16_t)(sign | half);
+	}
+
+	//Round to nearest even on the 13 bits we drop. A carry into the exponent is fine.
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+	return (uint16_t)half;
+}
+
+float halfToFloat(uint16_t h) {
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+	uint32_t bits;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		}
+		else {
+			//Denormal, normalise it.
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0) {
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+	}
+	else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+glm::vec2 octEncode(glm::vec3 n) {
+	float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (l1 == 0.0f) return glm::vec2(0.0f, 0.0f);
+	n = n / l1;
+	glm::vec2 e = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		//Fold the lower half over the diagonals.
+		e.x = (1.0f - fabsf(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		e.y = (1.0f - fabsf(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return e;
+}
+
+glm::vec3 octDecode(glm::vec2 e) {
+	glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+	float t = n.z < 0.0f ? -n.z : 0.0f;
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+static uint16_t toUnorm16(float v) {
+	v = glm::clamp(v, 0.0f, 1.0f);
+	return (uint16_t)(v * 65535.0f + 0.5f);
+}
+
+static int16_t toSnorm16(float v) {
+	v = glm::clamp(v, -1.0f, 1.0f);
+	return (int16_t)(v >= 0.0f ? v * 32767.0f + 0.5f : v * 32767.0f - 0.5f);
+}
+
+void packMesh(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& vertices,
+	const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals, PackedMesh& out) {
+	out.indices = indices;
+	out.vertices.resize(vertices.size());
+
+	//UVs go past [0,1] (loadOBJ flips V to negative), so quantize over the mesh's own range.
+	glm::vec2 uvMin = glm::vec2(0.0f), uvMax = glm::vec2(1.0f);
+	if (!uvs.empty()) {
+		uvMin = uvMax = uvs[0];
+		for (size_t i = 1; i < uvs.size(); i++) {
+			uvMin = glm::min(uvMin, uvs[i]);
+			uvMax = glm::max(uvMax, uvs[i]);
+		}
+	}
+	glm::vec2 uvScale = uvMax - uvMin;
+	if (uvScale.x == 0.0f) uvScale.x = 1.0f;
+	if (uvScale.y == 0.0f) uvScale.y = 1.0f;
+	out.uvTransform = glm::vec4(uvMin.x, uvMin.y, uvScale.x, uvScale.y);
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		PackedVertex& p = out.vertices[i];
+		p.position[0] = floatToHalf(vertices[i].x);
+		p.position[1] = floatToHalf(vertices[i].y);
+		p.position[2] = floatToHalf(vertices[i].z);
+		p.position[3] = floatToHalf(1.0f);
+
+		glm::vec2 uv = i < uvs.size() ? uvs[i] : glm::vec2(0.0f);
+		p.uv[0] = toUnorm16((uv.x - uvMin.x) / uvScale.x);
+		p.uv[1] = toUnorm16((uv.y - uvMin.y) / uvScale.y);
+
+		glm::vec2 oct = octEncode(i < normals.size() ? normals[i] : glm::vec3(0.0f, 0.0f, 1.0f));
+		p.normal[0] = toSnorm16(oct.x);
+		p.normal[1] = toSnorm16(oct.y);
+	}
+}
+
+void printVertexMemory(const char* name, size_t count) {
+	printf("%s : %u vertices, %u -> %u bytes per vertex (%.1f KB -> %.1f KB)\n", name, (unsigned int)count,
+		(unsigned int)UNPACKED_VERTEX_SIZE, (unsigned int)sizeof(PackedVertex),
+		count * UNPACKED_VERTEX_SIZE / 1024.0, count * sizeof(PackedVertex) / 1024.0);
+}
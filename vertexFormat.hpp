@@ -0,0 +1,43 @@
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+
+// Compact interleaved vertex used for every body mesh on the GPU:
+//
+//   offset 0  position  4 x half float (w is padding, always 1)
+//   offset 8  uv        2 x unorm16, mapped onto the mesh's UV range by uvTransform
+//   offset 12 normal    2 x snorm16, octahedral encoding
+//
+// 16 bytes against 32 for separate float positions, UVs and normals.
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct PackedVertex {
+	uint16_t position[4];
+	uint16_t uv[2];
+	int16_t normal[2];
+};
+
+struct PackedMesh {
+	std::vector<PackedVertex> vertices;
+	std::vector<unsigned int> indices;
+	glm::vec4 uvTransform; // uv = uvTransform.xy + (quantized uv / 65535) * uvTransform.zw
+};
+
+// Bytes per vertex of the old layout: vec3 position, vec2 uv and vec3 normal as floats.
+const size_t UNPACKED_VERTEX_SIZE = sizeof(glm::vec3) + sizeof(glm::vec2) + sizeof(glm::vec3);
+
+uint16_t floatToHalf(float f);
+float halfToFloat(uint16_t h);
+
+// Unit vector to a point on the octahedron folded into [-1,1]^2, and back.
+glm::vec2 octEncode(glm::vec3 n);
+glm::vec3 octDecode(glm::vec2 e);
+
+void packMesh(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& vertices,
+	const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals, PackedMesh& out);
+
+// Log the vertex memory of a mesh in the old and the packed layout.
+void printVertexMemory(const char* name, size_t vertexCount);
+
+#endif
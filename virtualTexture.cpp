@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <GL/glew.h>
+
+#include "virtualTexture.hpp"
+#include "glState.hpp"
+#include "hash.hpp"
+#include "mappedFile.hpp"
+#include "resourceManager.hpp"
+#include "threadPool.hpp"
+
+//Tile reads on the pool at once, and uploads per frame. An upload is a
+//TILE_PAGE_SIZE square, 72 KB at 4 channels.
+static const size_t MAX_TILE_LOADS = 32;
+static const int MAX_TILE_UPLOADS = 16;
+
+static const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+VirtualTexture::VirtualTexture(ThreadPool* pool) : pool(pool), format(GL_RGBA), cache(0), indirection(0),
+	indirectionDirty(false), feedbackCount(0), framebuffer(0), feedbackColor(0), feedbackDepth(0),
+	feedbackWidth(0), feedbackHeight(0), nextReadback(0), oldestReadback(0),
+	tilesRequested(0), uploads(0), evictions(0), dropped(0) {
+	memset(savedViewport, 0, sizeof(savedViewport));
+}
+
+void VirtualTexture::release() {
+	for (size_t i = 0; i < loads.size(); i++) {
+		if (loads[i]->done.valid()) loads[i]->done.wait();
+	}
+	loads.clear();
+	for (int i = 0; i < 2; i++) {
+		if (readbacks[i].fence) glDeleteSync(readbacks[i].fence);
+		if (readbacks[i].buffer) glDeleteBuffers(1, &readbacks[i].buffer);
+		readbacks[i] = Readback();
+	}
+	if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+	if (feedbackColor) glDeleteTextures(1, &feedbackColor);
+	if (feedbackDepth) glDeleteRenderbuffers(1, &feedbackDepth);
+	if (cache) glDeleteTextures(1, &cache);
+	if (indirection) glDeleteTextures(1, &indirection);
+	framebuffer = feedbackColor = feedbackDepth = cache = indirection = 0;
+	feedbackWidth = feedbackHeight = 0;
+	pages.clear();
+	tilePage.clear();
+	tileSeen.clear();
+	tileLoading.clear();
+	wanted.clear();
+	entries.clear();
+	tiles.file.close();
+}
+
+bool VirtualTexture::open(const char* imagePath) {
+	release();
+	//Checked against the image when it's there, trusted when it isn't.
+	uint64_t sourceHash = 0, sourceSize = 0;
+	MappedFile source;
+	if (source.open(imagePath) && source.size() > 0) {
+		sourceHash = hashBytes(source.data(), source.size());
+		sourceSize = source.size();
+	}
+	source.close();
+	std::string tiledPath = tiledTexturePath(imagePath);
+	if (!openTiledTexture(tiledPath.c_str(), sourceHash, sourceSize, tiles)) return false;
+	name = imagePath;
+	format = formats[tiles.header.channels];
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	int cacheSize = VIRTUAL_CACHE_PAGES * TILE_PAGE_SIZE;
+	glGenTextures(1, &cache);
+	glBindTexture(GL_TEXTURE_2D, cache);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, cacheSize, cacheSize, 0, format, GL_UNSIGNED_BYTE, NULL);
+	//Level 0 only: the tile levels are the mips. The borders keep bilinear inside a page.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	//A mip per tile level, read with texelFetch only.
+	int levels = tiles.levelCount();
+	glGenTextures(1, &indirection);
+	glBindTexture(GL_TEXTURE_2D, indirection);
+	for (int level = 0; level < levels; level++) {
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, tiles.tilesWide(level), tiles.tilesHigh(level), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	pages.assign(VIRTUAL_CACHE_PAGES * VIRTUAL_CACHE_PAGES, Page());
+	tilePage.assign(tiles.tileCount(), -1);
+	tileSeen.assign(tiles.tileCount(), 0);
+	tileLoading.assign(tiles.tileCount(), false);
+	entries.resize(tiles.tileCount() * 4);
+
+	//The last level is one tile, and stays in for good: every tile falls back to it.
+	size_t top = tiles.tileIndex(levels - 1, 0, 0);
+	uploadTile(top, tiles.tile(top), true);
+	updateIndirection();
+	return true;
+}
+
+void VirtualTexture::setUniforms(Program& program, int cacheUnit, int indirectionUnit, bool feedback) const {
+	glUseProgram(program.id);
+	glUniform1i(program.uniform("pageCache"), cacheUnit);
+	glUniform1i(program.uniform("indirection"), indirectionUnit);
+	glUniform2f(program.uniform("virtualSize"), (float)tiles.header.width, (float)tiles.header.height);
+	glUniform2f(program.uniform("tileCount"), (float)tiles.tilesWide(0), (float)tiles.tilesHigh(0));
+	glUniform1f(program.uniform("maxLevel"), (float)(tiles.levelCount() - 1));
+	glUniform1f(program.uniform("tileSize"), (float)TILE_SIZE);
+	glUniform1f(program.uniform("tileBorder"), (float)TILE_BORDER);
+	glUniform1f(program.uniform("cachePages"), (float)VIRTUAL_CACHE_PAGES);
+	//Feedback pixels each cover VIRTUAL_FEEDBACK_SCALE screen pixels each way,
+	//so their UVs change that much faster: take it back off the level.
+	glUniform1f(program.uniform("lodBias"), feedback ? -log2f((float)VIRTUAL_FEEDBACK_SCALE) : 0.0f);
+}
+
+void VirtualTexture::bindTextures(int cacheUnit, int indirectionUnit, GLStateCache* state) const {
+	if (state) {
+		state->bindTexture(cacheUnit, GL_TEXTURE_2D, cache);
+		state->bindTexture(indirectionUnit, GL_TEXTURE_2D, indirection);
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + cacheUnit);
+	glBindTexture(GL_TEXTURE_2D, cache);
+	glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+	glBindTexture(GL_TEXTURE_2D, indirection);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void VirtualTexture::beginFeedback(int screenWidth, int screenHeight) {
+	int width = std::max(1, screenWidth / VIRTUAL_FEEDBACK_SCALE);
+	int height = std::max(1, screenHeight / VIRTUAL_FEEDBACK_SCALE);
+	if (!framebuffer) {
+		glGenFramebuffers(1, &framebuffer);
+		glGenTextures(1, &feedbackColor);
+		glGenRenderbuffers(1, &feedbackDepth);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	if (width != feedbackWidth || height != feedbackHeight) {
+		glBindTexture(GL_TEXTURE_2D, feedbackColor);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+		feedbackWidth = width;
+		feedbackHeight = height;
+	}
+
+	glGetIntegerv(GL_VIEWPORT, savedViewport);
+	glViewport(0, 0, feedbackWidth, feedbackHeight);
+	//Alpha 0 is "nothing here".
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void VirtualTexture::endFeedback() {
+	//Into a pixel buffer, so glReadPixels returns at once. If both are still
+	//on their way this frame's feedback is skipped rather than waited for.
+	Readback& readback = readbacks[nextReadback];
+	if (!readback.fence) {
+		if (!readback.buffer) glGenBuffers(1, &readback.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		if (readback.width != feedbackWidth || readback.height != feedbackHeight) {
+			glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)feedbackWidth * feedbackHeight * 4, NULL, GL_STREAM_READ);
+			readback.width = feedbackWidth;
+			readback.height = feedbackHeight;
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		nextReadback = 1 - nextReadback;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+void VirtualTexture::update() {
+	if (!cache) return;
+
+	//The oldest feedback, if the GPU is done with it.
+	Readback& readback = readbacks[oldestReadback];
+	if (readback.fence) {
+		GLenum status = glClientWaitSync(readback.fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			glDeleteSync(readback.fence);
+			readback.fence = 0;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+			size_t bytes = (size_t)readback.width * readback.height * 4;
+			const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+			if (pixels) {
+				readFeedback(pixels, readback.width, readback.height);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			oldestReadback = 1 - oldestReadback;
+		}
+	}
+
+	startLoads();
+
+	//Uploads in the order the reads were started, coarse levels first.
+	int uploaded = 0;
+	while (!loads.empty() && uploaded < MAX_TILE_UPLOADS) {
+		TileLoad& load = *loads.front();
+		if (load.done.valid()) {
+			if (load.done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) break;
+			load.done.get();
+		}
+		tileLoading[load.tile] = false;
+		if (uploadTile(load.tile, &load.pixels[0], false)) uploaded++;
+		loads.pop_front();
+	}
+
+	if (indirectionDirty) updateIndirection();
+}
+
+void VirtualTexture::readFeedback(const unsigned char* pixels, int width, int height) {
+	feedbackCount++;
+	tilesRequested = 0;
+	wanted.clear();
+	int levels = tiles.levelCount();
+	for (size_t i = 0, count = (size_t)width * height; i < count; i++) {
+		const unsigned char* p = pixels + i * 4;
+		if (p[3] == 0 || p[2] >= levels) continue;
+		int level = p[2];
+		request(level, std::min((int)p[0], tiles.tilesWide(level) - 1), std::min((int)p[1], tiles.tilesHigh(level) - 1));
+	}
+	//Tiles are numbered level by level from level 0, so this puts the coarsest
+	//at the end, where startLoads() takes them from: each one fixes up a larger
+	//area while the finer ones stream in.
+	std::sort(wanted.begin(), wanted.end());
+}
+
+//The tile and every coarser one over it: those are its fallbacks, so they
+//should be in, and not be the next pages to go.
+void VirtualTexture::request(int level, int x, int y) {
+	for (int levels = tiles.levelCount(); level < levels; level++, x /= 2, y /= 2) {
+		size_t tile = tiles.tileIndex(level, x, y);
+		if (tileSeen[tile] == feedbackCount) return;
+		tileSeen[tile] = feedbackCount;
+		tilesRequested++;
+		if (tilePage[tile] >= 0) {
+			Page& page = pages[tilePage[tile]];
+			if (!page.pinned) page.lastUsed = feedbackCount;
+		} else if (!tileLoading[tile]) wanted.push_back(tile);
+	}
+}
+
+void VirtualTexture::startLoads() {
+	while (!wanted.empty() && loads.size() < MAX_TILE_LOADS) {
+		size_t tile = wanted.back();
+		wanted.pop_back();
+		if (tilePage[tile] >= 0 || tileLoading[tile]) continue;
+		tileLoading[tile] = true;
+
+		std::unique_ptr<TileLoad> load(new TileLoad());
+		load->tile = tile;
+		load->pixels.resize(tiles.tilePageBytes());
+		//Touching the mapped tile is what reads it from disk, so the copy is the load.
+		TileLoad* job = load.get();
+		const TiledTexture* source = &tiles;
+		auto read = [job, source]() { memcpy(&job->pixels[0], source->tile(job->tile), job->pixels.size()); };
+		if (pool) load->done = pool->submit(read);
+		else read();
+		loads.push_back(std::move(load));
+	}
+}
+
+bool VirtualTexture::uploadTile(size_t tile, const unsigned char* pixels, bool pinned) {
+	if (tilePage[tile] >= 0) return false;
+
+	//A free page, else the one seen longest ago that the last feedback didn't
+	//ask for. Pinned ones are never taken.
+	int best = -1;
+	for (int i = 0; i < (int)pages.size(); i++) {
+		const Page& page = pages[i];
+		if (page.tile < 0) {
+			best = i;
+			break;
+		}
+		if (page.pinned) continue;
+		if (page.lastUsed < feedbackCount && (best < 0 || page.lastUsed < pages[best].lastUsed)) best = i;
+	}
+	if (best < 0) {
+		//Everything in the cache is on screen. The tile is asked for again by the next feedback.
+		dropped++;
+		return false;
+	}
+	Page& page = pages[best];
+	if (page.tile >= 0) {
+		tilePage[page.tile] = -1;
+		evictions++;
+	}
+	page.tile = (int64_t)tile;
+	page.lastUsed = feedbackCount;
+	page.pinned = pinned;
+	tilePage[tile] = best;
+
+	int x = best % VIRTUAL_CACHE_PAGES, y = best / VIRTUAL_CACHE_PAGES;
+	glBindTexture(GL_TEXTURE_2D, cache);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x * TILE_PAGE_SIZE, y * TILE_PAGE_SIZE, TILE_PAGE_SIZE, TILE_PAGE_SIZE,
+		format, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	uploads++;
+	indirectionDirty = true;
+	return true;
+}
+
+//Rebuilt from the top level down: a tile that's in points at its own page,
+//one that isn't copies its parent's entry.
+void VirtualTexture::updateIndirection() {
+	glBindTexture(GL_TEXTURE_2D, indirection);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int level = tiles.levelCount() - 1; level >= 0; level--) {
+		int wide = tiles.tilesWide(level), high = tiles.tilesHigh(level);
+		for (int y = 0; y < high; y++) {
+			for (int x = 0; x < wide; x++) {
+				size_t tile = tiles.tileIndex(level, x, y);
+				unsigned char* entry = &entries[tile * 4];
+				int page = tilePage[tile];
+				if (page < 0 && level == tiles.levelCount() - 1) {
+					//The pinned top tile is always in, see open(). Should it not
+					//be, there is no parent to copy: point at page 0 and carry on.
+					page = 0;
+				}
+				if (page >= 0) {
+					entry[0] = (unsigned char)(page % VIRTUAL_CACHE_PAGES);
+					entry[1] = (unsigned char)(page / VIRTUAL_CACHE_PAGES);
+					entry[2] = (unsigned char)level;
+					entry[3] = 255;
+				} else {
+					size_t parent = tiles.tileIndex(level + 1, std::min(x / 2, tiles.tilesWide(level + 1) - 1),
+						std::min(y / 2, tiles.tilesHigh(level + 1) - 1));
+					memcpy(entry, &entries[parent * 4], 4);
+				}
+			}
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, wide, high, GL_RGBA, GL_UNSIGNED_BYTE, &entries[tiles.firstTile[level] * 4]);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	indirectionDirty = false;
+}
+
+void VirtualTexture::printStats() const {
+	if (!cache) return;
+	size_t resident = 0;
+	for (size_t i = 0; i < pages.size(); i++) resident += pages[i].tile >= 0;
+	double cacheMB = (double)pages.size() * TILE_PAGE_SIZE * TILE_PAGE_SIZE * tiles.header.channels / (1024.0 * 1024.0);
+	double diskMB = (double)tiles.tileCount() * tiles.tilePageBytes() / (1024.0 * 1024.0);
+	printf("Virtual texture %s : %ux%u, %d levels, %u tiles (%.1f MB) on disk, %dx%d page cache (%.1f MB)\n",
+		name.c_str(), tiles.header.width, tiles.header.height, tiles.levelCount(), (unsigned int)tiles.tileCount(), diskMB,
+		VIRTUAL_CACHE_PAGES, VIRTUAL_CACHE_PAGES, cacheMB);
+	printf("  %u feedback frames, %u tiles asked for by the last, %u pages in use, %u uploads, %u evictions, %u dropped for want of a page\n",
+		feedbackCount, tilesRequested, (unsigned int)resident, uploads, evictions, dropped);
+}
@@ -0,0 +1,134 @@
+#ifndef VIRTUALTEXTURE_HPP
+#define VIRTUALTEXTURE_HPP
+
+// Sparse virtual texturing over the tiles of a .vtex file (tiledTexture.hpp),
+// for images far too big to keep in memory. Only the tiles something on
+// screen samples are on the GPU, in a page cache texture of
+// VIRTUAL_CACHE_PAGES x VIRTUAL_CACHE_PAGES tiles. An indirection table, one
+// texel per tile and one mip per tile level, tells the shader which page
+// holds a tile, or the nearest coarser tile that's in while it streams.
+//
+// What's needed comes from a feedback pass: whatever uses the texture is drawn
+// again into a small framebuffer by a shader that writes the tile and level
+// each pixel would sample. It's read back through pixel buffers a frame or two
+// later, so the CPU never waits on the GPU for it. Missing tiles are read from
+// the mapped file on the pool and uploaded a few per frame, into the pages
+// seen longest ago.
+//
+// Plain GL 3.3 (textures, a framebuffer, pixel buffers, fences), no sparse
+// texture extension, so llvmpipe runs it as well as any GPU.
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+#include "tiledTexture.hpp"
+
+class GLStateCache;
+class ThreadPool;
+struct Program;
+
+// Page cache size, in tiles each way. Page coordinates go through 8 bit channels.
+const int VIRTUAL_CACHE_PAGES = 16;
+
+// The feedback framebuffer is the screen divided by this each way.
+const int VIRTUAL_FEEDBACK_SCALE = 8;
+
+class VirtualTexture {
+public:
+	// Tiles are read on pool when given one.
+	explicit VirtualTexture(ThreadPool* pool = NULL);
+	~VirtualTexture() { release(); }
+
+	// Waits for tile reads still going on. GL calls, so while the context exists.
+	void release();
+
+	// Opens imagePath's .vtex and makes the GL objects, with the coarsest
+	// level already in so there is something to draw from the first frame.
+	// False when there is no usable .vtex. The image itself needn't be there.
+	bool open(const char* imagePath);
+	bool isOpen() const { return cache != 0; }
+
+	// Points program's samplers at these texture units and gives it the
+	// texture's dimensions. Once per program; the drawing and the feedback
+	// shader take the same uniforms.
+	void setUniforms(Program& program, int cacheUnit, int indirectionUnit, bool feedback) const;
+	// Through state when given one, the other binding calls don't use it:
+	// invalidate it after update().
+	void bindTextures(int cacheUnit, int indirectionUnit, GLStateCache* state = NULL) const;
+
+	// Draw what uses the texture with the feedback program between these.
+	// The size is the framebuffer's, the feedback one is a fraction of it.
+	// endFeedback() puts back framebuffer 0 and the viewport.
+	void beginFeedback(int screenWidth, int screenHeight);
+	void endFeedback();
+
+	// Once a frame on the GL thread, before drawing with the texture: takes in
+	// the feedback that has arrived, starts reading the missing tiles, uploads
+	// the ones that are read and updates the indirection table.
+	void update();
+
+	void printStats() const;
+
+private:
+	VirtualTexture(const VirtualTexture&);
+	VirtualTexture& operator=(const VirtualTexture&);
+
+	struct Page {
+		Page() : tile(-1), lastUsed(0), pinned(false) {}
+		int64_t tile;      // -1 when free.
+		uint32_t lastUsed; // Feedback that last asked for it.
+		bool pinned;       // Never evicted (the top level's tile).
+	};
+
+	struct TileLoad {
+		size_t tile;
+		std::vector<unsigned char> pixels;
+		std::future<void> done;
+	};
+
+	struct Readback {
+		Readback() : buffer(0), fence(0), width(0), height(0) {}
+		GLuint buffer;
+		GLsync fence; // Set while the read is on its way.
+		int width, height;
+	};
+
+	void readFeedback(const unsigned char* pixels, int width, int height);
+	void request(int level, int x, int y);
+	void startLoads();
+	bool uploadTile(size_t tile, const unsigned char* pixels, bool pinned);
+	void updateIndirection();
+
+	ThreadPool* pool;
+	std::string name;
+	TiledTexture tiles;
+	GLenum format;
+
+	GLuint cache;       // The pages.
+	GLuint indirection; // RGBA8 : page x, page y, level of the tile that's there, 255.
+	std::vector<Page> pages;
+	std::vector<int> tilePage;          // Page of each tile, -1 when not in.
+	std::vector<uint32_t> tileSeen;     // Feedback that last asked for each tile.
+	std::vector<bool> tileLoading;
+	std::vector<size_t> wanted;         // Asked for, not in and not loading.
+	std::deque<std::unique_ptr<TileLoad> > loads;
+	std::vector<unsigned char> entries; // Indirection table, all levels.
+	bool indirectionDirty;
+	uint32_t feedbackCount;
+
+	GLuint framebuffer, feedbackColor, feedbackDepth;
+	int feedbackWidth, feedbackHeight;
+	GLint savedViewport[4];
+	Readback readbacks[2]; // Written and read in turn.
+	int nextReadback, oldestReadback;
+
+	unsigned int tilesRequested; // By the last feedback, coarser levels included.
+	unsigned int uploads, evictions, dropped;
+};
+
+#endif